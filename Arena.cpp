@@ -0,0 +1,57 @@
+#include "Arena.hpp"
+
+#include <algorithm>
+
+namespace schrodinger
+{
+namespace mae
+{
+
+// C++ wart; class static const definitions. See Item 2 of Effective C++
+// (3rd ed).
+const size_t Arena::DEFAULT_CHUNK_SIZE;
+
+Arena::Arena(size_t chunk_size)
+    : m_chunks(), m_current(nullptr), m_mutex(),
+      m_chunk_size(std::max<size_t>(chunk_size, 1024))
+{
+    m_chunks.emplace_back(new Chunk(m_chunk_size));
+    m_current.store(m_chunks.back().get(), std::memory_order_release);
+}
+
+void* Arena::allocateSlow(size_t bytes, size_t alignment, Chunk* full)
+{
+    const size_t reserve = bytes + alignment - 1;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Large requests get a chunk of their own rather than abandoning the
+        // remainder of the current one.
+        if (reserve > m_chunk_size / 4) {
+            m_chunks.emplace_back(new Chunk(reserve));
+            Chunk* chunk = m_chunks.back().get();
+            chunk->used.store(reserve, std::memory_order_relaxed);
+            return align(chunk->data.get(), alignment);
+        }
+
+        // Another thread may have replaced the full chunk already.
+        if (m_current.load(std::memory_order_acquire) == full) {
+            m_chunks.emplace_back(new Chunk(m_chunk_size));
+            m_current.store(m_chunks.back().get(), std::memory_order_release);
+        }
+    }
+    return allocate(bytes, alignment);
+}
+
+size_t Arena::capacity()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t total = 0;
+    for (const auto& chunk : m_chunks) {
+        total += chunk->size;
+    }
+    return total;
+}
+
+} // namespace mae
+} // namespace schrodinger
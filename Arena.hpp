@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "MaeParserConfig.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+/**
+ * A monotonic memory region.
+ *
+ * Allocation bumps an offset within the current chunk; individual
+ * deallocations are ignored and all memory is released at once when the
+ * Arena is destroyed. Allocation is safe from multiple threads, which allows
+ * lazily materialized data to share the Arena of the block that owns it.
+ */
+class EXPORT_MAEPARSER Arena
+{
+  private:
+    class Chunk
+    {
+      public:
+        std::unique_ptr<char[]> data;
+        size_t size;
+        std::atomic<size_t> used;
+
+        explicit Chunk(size_t chunk_size)
+            : data(new char[chunk_size]), size(chunk_size), used(0)
+        {
+        }
+    };
+
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    std::atomic<Chunk*> m_current;
+    std::mutex m_mutex;
+    size_t m_chunk_size;
+
+    void* allocateSlow(size_t bytes, size_t alignment, Chunk* full);
+
+    static void* align(char* ptr, size_t alignment)
+    {
+        const auto misalignment =
+            reinterpret_cast<std::uintptr_t>(ptr) & (alignment - 1);
+        return misalignment ? ptr + (alignment - misalignment) : ptr;
+    }
+
+  public:
+    static const size_t DEFAULT_CHUNK_SIZE = 65536;
+
+    explicit Arena(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * Return 'bytes' bytes of storage aligned to 'alignment', which must be a
+     * power of two.
+     */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+    {
+        Chunk* chunk = m_current.load(std::memory_order_acquire);
+        // Reserve enough to align within the reservation, wherever it lands.
+        const size_t reserve = bytes + alignment - 1;
+        const size_t offset =
+            chunk->used.fetch_add(reserve, std::memory_order_relaxed);
+        if (offset + reserve > chunk->size) {
+            return allocateSlow(bytes, alignment, chunk);
+        }
+        return align(chunk->data.get() + offset, alignment);
+    }
+
+    /**
+     * Return the total size of the chunks held by the Arena.
+     */
+    size_t capacity();
+};
+
+/**
+ * A C++11 allocator that draws from a shared Arena, or from the global heap
+ * if it has none.
+ *
+ * Every allocator (and so every container and shared_ptr control block that
+ * uses one) holds a reference to its Arena, so the region lives exactly as
+ * long as the last object allocated in it.
+ */
+template <typename T> class ArenaAllocator
+{
+  private:
+    std::shared_ptr<Arena> m_arena;
+
+    template <typename U> friend class ArenaAllocator;
+
+  public:
+    using value_type = T;
+
+    ArenaAllocator() = default;
+
+    explicit ArenaAllocator(std::shared_ptr<Arena> arena)
+        : m_arena(std::move(arena))
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.m_arena)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if (m_arena == nullptr) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t)
+    {
+        if (m_arena == nullptr) {
+            ::operator delete(ptr);
+        }
+    }
+
+    const std::shared_ptr<Arena>& arena() const { return m_arena; }
+
+    template <typename U> bool operator==(const ArenaAllocator<U>& rhs) const
+    {
+        return m_arena == rhs.m_arena;
+    }
+
+    template <typename U> bool operator!=(const ArenaAllocator<U>& rhs) const
+    {
+        return m_arena != rhs.m_arena;
+    }
+};
+
+/**
+ * Create a shared object, with its control block, in the provided Arena, or
+ * in a single heap allocation if the Arena is null.
+ */
+template <typename T, typename... Args>
+inline std::shared_ptr<T>
+allocate_shared_in(const std::shared_ptr<Arena>& arena, Args&&... args)
+{
+    return std::allocate_shared<T>(ArenaAllocator<T>(arena),
+                                   std::forward<Args>(args)...);
+}
+
+} // namespace mae
+} // namespace schrodinger
@@ -0,0 +1,101 @@
+#include "Bitmap.hpp"
+
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace schrodinger
+{
+namespace mae
+{
+
+namespace
+{
+inline size_t popcount(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return __popcnt64(word);
+#else
+    size_t count = 0;
+    for (; word; word &= word - 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+} // namespace
+
+Bitmap::Bitmap(size_t size, bool value)
+    : m_words(wordCount(size), value ? ~uint64_t(0) : 0), m_size(size)
+{
+    clearTail();
+}
+
+void Bitmap::clearTail()
+{
+    if (m_size % 64 != 0) {
+        m_words.back() &= (uint64_t(1) << (m_size % 64)) - 1;
+    }
+}
+
+void Bitmap::resize(size_t size, bool value)
+{
+    if (value && size > m_size) {
+        if (m_size % 64 != 0) {
+            m_words.back() |= ~((uint64_t(1) << (m_size % 64)) - 1);
+        }
+        m_words.resize(wordCount(size), ~uint64_t(0));
+    } else {
+        m_words.resize(wordCount(size), 0);
+    }
+    m_size = size;
+    clearTail();
+}
+
+size_t Bitmap::count() const
+{
+    size_t count = 0;
+    for (auto word : m_words) {
+        count += popcount(word);
+    }
+    return count;
+}
+
+bool Bitmap::any() const
+{
+    for (auto word : m_words) {
+        if (word != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Bitmap& Bitmap::operator&=(const Bitmap& rhs)
+{
+    if (m_size != rhs.m_size) {
+        throw std::invalid_argument("Bitmap sizes differ.");
+    }
+    for (size_t i = 0; i < m_words.size(); ++i) {
+        m_words[i] &= rhs.m_words[i];
+    }
+    return *this;
+}
+
+Bitmap& Bitmap::operator|=(const Bitmap& rhs)
+{
+    if (m_size != rhs.m_size) {
+        throw std::invalid_argument("Bitmap sizes differ.");
+    }
+    for (size_t i = 0; i < m_words.size(); ++i) {
+        m_words[i] |= rhs.m_words[i];
+    }
+    return *this;
+}
+
+} // namespace mae
+} // namespace schrodinger
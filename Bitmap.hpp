@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MaeParserConfig.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+/**
+ * A packed sequence of bits, stored 64 to a word.
+ *
+ * Bit i is bit (i % 64) of word (i / 64), counting from the least
+ * significant bit, and the unused bits of the last word are always zero. On
+ * little-endian machines this is byte-for-byte the layout of an Apache Arrow
+ * validity bitmap. Counting and combining bitmaps operate on whole words.
+ */
+class EXPORT_MAEPARSER Bitmap
+{
+  private:
+    std::vector<uint64_t> m_words;
+    size_t m_size{0};
+
+    static size_t wordCount(size_t bits) { return (bits + 63) / 64; }
+
+    void clearTail();
+
+  public:
+    Bitmap() = default;
+
+    explicit Bitmap(size_t size, bool value = false);
+
+    size_t size() const { return m_size; }
+
+    bool empty() const { return m_size == 0; }
+
+    bool test(size_t index) const
+    {
+        assert(index < m_size);
+        return (m_words[index / 64] >> (index % 64)) & 1u;
+    }
+
+    void set(size_t index)
+    {
+        assert(index < m_size);
+        m_words[index / 64] |= uint64_t(1) << (index % 64);
+    }
+
+    void set(size_t index, bool value)
+    {
+        if (value) {
+            set(index);
+        } else {
+            reset(index);
+        }
+    }
+
+    void reset(size_t index)
+    {
+        assert(index < m_size);
+        m_words[index / 64] &= ~(uint64_t(1) << (index % 64));
+    }
+
+    void push_back(bool value)
+    {
+        if (m_size % 64 == 0) {
+            m_words.push_back(0);
+        }
+        if (value) {
+            m_words.back() |= uint64_t(1) << (m_size % 64);
+        }
+        ++m_size;
+    }
+
+    void reserve(size_t size) { m_words.reserve(wordCount(size)); }
+
+    void resize(size_t size, bool value = false);
+
+    /**
+     * Return the number of set bits.
+     */
+    size_t count() const;
+
+    bool all() const { return count() == m_size; }
+
+    bool any() const;
+
+    bool none() const { return !any(); }
+
+    /**
+     * Combine with a bitmap of the same size.
+     */
+    Bitmap& operator&=(const Bitmap& rhs);
+    Bitmap& operator|=(const Bitmap& rhs);
+
+    bool operator==(const Bitmap& rhs) const
+    {
+        return m_size == rhs.m_size && m_words == rhs.m_words;
+    }
+
+    bool operator!=(const Bitmap& rhs) const { return !(operator==(rhs)); }
+
+    /**
+     * Return the underlying words, with the unused bits of the last word
+     * cleared.
+     */
+    const uint64_t* words() const { return m_words.data(); }
+};
+
+} // namespace mae
+} // namespace schrodinger
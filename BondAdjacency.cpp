@@ -0,0 +1,115 @@
+#include "BondAdjacency.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+namespace
+{
+struct Neighbor {
+    uint32_t atom;
+    uint32_t bond;
+    int order;
+
+    bool operator<(const Neighbor& rhs) const
+    {
+        return atom < rhs.atom || (atom == rhs.atom && bond < rhs.bond);
+    }
+};
+} // namespace
+
+BondAdjacency::BondAdjacency(size_t atom_count, const std::vector<int>& atom_1,
+                             const std::vector<int>& atom_2,
+                             const std::vector<int>& order)
+    : m_offsets(atom_count + 1, 0)
+{
+    const size_t bond_count = atom_1.size();
+    if (atom_2.size() != bond_count || order.size() != bond_count) {
+        throw std::invalid_argument("Bond columns differ in size.");
+    }
+    if (atom_count > UINT32_MAX || bond_count > UINT32_MAX) {
+        throw std::out_of_range("Too many atoms or bonds for an adjacency.");
+    }
+
+    // Count the entries of each atom, then place them with a prefix sum.
+    for (size_t i = 0; i < bond_count; ++i) {
+        for (int atom : {atom_1[i], atom_2[i]}) {
+            if (atom < 1 || static_cast<size_t>(atom) > atom_count) {
+                throw std::out_of_range("Bond to a nonexistent atom.");
+            }
+            ++m_offsets[atom];
+        }
+    }
+    for (size_t atom = 0; atom < atom_count; ++atom) {
+        m_offsets[atom + 1] += m_offsets[atom];
+    }
+    std::vector<Neighbor> entries(m_offsets.back());
+    std::vector<uint32_t> next(m_offsets.begin(), m_offsets.end() - 1);
+    for (size_t i = 0; i < bond_count; ++i) {
+        const uint32_t a = atom_1[i] - 1;
+        const uint32_t b = atom_2[i] - 1;
+        const auto bond = static_cast<uint32_t>(i);
+        entries[next[a]++] = {b, bond, order[i]};
+        entries[next[b]++] = {a, bond, order[i]};
+    }
+
+    // Sort each atom's neighbors, keeping the first row that lists a bond.
+    m_neighbors.reserve(entries.size());
+    m_orders.reserve(entries.size());
+    m_bonds.reserve(entries.size());
+    uint32_t begin = 0;
+    for (size_t atom = 0; atom < atom_count; ++atom) {
+        const uint32_t end = m_offsets[atom + 1];
+        std::sort(entries.begin() + begin, entries.begin() + end);
+        m_offsets[atom] = static_cast<uint32_t>(m_neighbors.size());
+        for (uint32_t i = begin; i < end; ++i) {
+            if (i > begin && entries[i].atom == entries[i - 1].atom) {
+                continue;
+            }
+            m_neighbors.push_back(entries[i].atom);
+            m_orders.push_back(entries[i].order);
+            m_bonds.push_back(entries[i].bond);
+        }
+        begin = end;
+    }
+    m_offsets.back() = static_cast<uint32_t>(m_neighbors.size());
+}
+
+namespace
+{
+size_t atom_count(const Block& ct)
+{
+    const auto indexed_blocks = ct.getIndexedBlockMap();
+    if (indexed_blocks == nullptr) {
+        return 0;
+    }
+    return indexed_blocks->getRowCount(PropertyKey(ATOM_BLOCK));
+}
+
+std::vector<int> bond_column(const Block& ct, const char* column)
+{
+    std::vector<int> values;
+    const auto indexed_blocks = ct.getIndexedBlockMap();
+    if (indexed_blocks != nullptr) {
+        indexed_blocks->getIntColumn(PropertyKey(BOND_BLOCK),
+                                     PropertyKey(column), values);
+    }
+    return values;
+}
+} // namespace
+
+BondAdjacency::BondAdjacency(const Block& ct)
+    : BondAdjacency(atom_count(ct), bond_column(ct, BOND_ATOM_1),
+                    bond_column(ct, BOND_ATOM_2), bond_column(ct, BOND_ORDER))
+{
+}
+
+} // namespace mae
+} // namespace schrodinger
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MaeParserConfig.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+class Block;
+
+/**
+ * The bonds of a structure as a compressed sparse row adjacency index.
+ *
+ * The neighbors of atom i are neighbors()[offsets()[i]] through
+ * neighbors()[offsets()[i + 1] - 1], in increasing order, with the matching
+ * bond orders in orders() and the m_bond rows that define them in bonds().
+ * Atoms and rows are indexed from zero, unlike the 1-based indices of the
+ * file.
+ *
+ * Each bond appears in the adjacency of both of its atoms, whether the
+ * m_bond block lists it once or in both directions.
+ */
+class EXPORT_MAEPARSER BondAdjacency
+{
+  private:
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_neighbors;
+    std::vector<int> m_orders;
+    std::vector<uint32_t> m_bonds;
+
+  public:
+    /**
+     * Build the adjacency of 'atom_count' atoms from the 1-based m_bond
+     * columns. Throws std::out_of_range if a bond refers to an atom outside
+     * the structure.
+     */
+    BondAdjacency(size_t atom_count, const std::vector<int>& atom_1,
+                  const std::vector<int>& atom_2,
+                  const std::vector<int>& order);
+
+    /**
+     * Build the adjacency of the m_atom and m_bond blocks of a block. For
+     * blocks read by a buffered parser only the bond columns are parsed,
+     * straight from the file's tokens.
+     */
+    explicit BondAdjacency(const Block& ct);
+
+    size_t atomCount() const { return m_offsets.size() - 1; }
+
+    size_t degree(size_t atom) const
+    {
+        assert(atom < atomCount());
+        return m_offsets[atom + 1] - m_offsets[atom];
+    }
+
+    const std::vector<uint32_t>& offsets() const { return m_offsets; }
+
+    const std::vector<uint32_t>& neighbors() const { return m_neighbors; }
+
+    const std::vector<int>& orders() const { return m_orders; }
+
+    const std::vector<uint32_t>& bonds() const { return m_bonds; }
+};
+
+} // namespace mae
+} // namespace schrodinger
@@ -30,6 +30,8 @@ Buffer::Buffer(const std::string& str) : Buffer(str.size())
 {
     const char* c = str.c_str();
     std::copy(c, c + str.size(), m_data.begin());
+    end = begin + str.size();
+    *end = '\0';
 }
 
 Buffer::~Buffer()
@@ -53,7 +55,7 @@ size_t Buffer::getColumn(const char* ptr) const
     return (save - ptr) + m_starting_column;
 }
 
-bool Buffer::load(char*& save)
+bool Buffer::load(char*& save, size_t min_size)
 {
     // begin, current, end are public member variables
     if (current < end) {
@@ -68,6 +70,7 @@ bool Buffer::load(char*& save)
     if (new_size == 0) {
         new_size = m_loader->getDefaultSize();
     }
+    new_size = std::max(new_size, min_size);
 
     size_t saved_chars = 0;
     if (save != nullptr) {
@@ -116,7 +119,7 @@ void BufferData::resize(size_t size)
         throw std::runtime_error("BufferData size can't be increased.");
     }
     m_size = size;
-    m_data[m_size + 1] = '\0';
+    m_data[m_size] = '\0';
 }
 
 bool BufferDataCollector::load(BufferData& data, const char* begin,
@@ -195,7 +198,7 @@ void TokenBufferList::appendBufferData(const BufferData& buffer_data)
     }
 
     TokenBuffer& previous_buffer = m_token_buffer_list.back();
-    size_t next_index = m_begin.size();
+    size_t next_index = m_tokens.size();
 
     // If the previous buffer stored no values, throw it away.
     if (previous_buffer.first_value == previous_buffer.last_value) {
@@ -208,10 +211,17 @@ void TokenBufferList::appendBufferData(const BufferData& buffer_data)
 void TokenBufferList::getData(size_t index, const char** const data,
                               size_t* const length) const
 {
-    // If this isn't true it means that getData was called before data
-    // collection was complete, which is an incorrect use of the API.
-    assert(m_begin.size() == m_end.size());
     auto token_buffer_iter = m_token_buffer_list.begin();
+    getData(index, data, length, token_buffer_iter);
+}
+
+void TokenBufferList::getData(size_t index, const char** const data,
+                              size_t* const length,
+                              const_iterator& token_buffer_iter) const
+{
+    if (index < token_buffer_iter->first_value) {
+        token_buffer_iter = m_token_buffer_list.begin();
+    }
 
     while (index >= token_buffer_iter->last_value) {
         ++token_buffer_iter;
@@ -220,8 +230,9 @@ void TokenBufferList::getData(size_t index, const char** const data,
         assert(token_buffer_iter != m_token_buffer_list.end());
     }
 
-    *length = m_end[index] - m_begin[index];
-    *data = token_buffer_iter->buffer_data.begin() + m_begin[index];
+    const auto& token = m_tokens[index];
+    *length = token.length;
+    *data = token_buffer_iter->buffer_data.begin() + token.begin;
 }
 
 } // namespace schrodinger
@@ -4,9 +4,11 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <memory>
 #include <sstream>
@@ -22,6 +24,9 @@ namespace schrodinger
 /**
  * A simple data class to hold unchanging character buffer data. Copies are
  * reference counted.
+ *
+ * The data is always followed by a '\0', so that scanners can stop on it
+ * rather than compare each position with the end of the data.
  */
 class EXPORT_MAEPARSER BufferData
 {
@@ -54,7 +59,7 @@ class EXPORT_MAEPARSER BufferData
      * Specifying a size larger than the current one throws a runtime_error.
      *
      * This doesn't actually free up any memory or modify the underlying
-     * character buffer.
+     * character buffer, beyond moving the terminating '\0'.
      */
     void resize(size_t size);
 };
@@ -176,6 +181,8 @@ class EXPORT_MAEPARSER Buffer
 
   public:
     char* begin{nullptr};
+    /// Always points at the '\0' that follows the loaded data, so a scan
+    /// only needs to check for the end when it reaches a '\0'.
     char* end{nullptr};
     char* current{nullptr};
     size_t line_number{1};
@@ -197,8 +204,8 @@ class EXPORT_MAEPARSER Buffer
     /**
      * Create a buffer from a string.
      *
-     * This makes a copy of the string data. Calls to load() always return
-     * false.
+     * This makes a copy of the string data, which is all loaded at once.
+     * Calls to load() return false once the buffer has been read.
      */
     explicit Buffer(const std::string& str);
 
@@ -230,7 +237,14 @@ class EXPORT_MAEPARSER Buffer
      *
      * Update Buffer pointers.
      */
-    bool load(char*& save);
+    bool load(char*& save) { return load(save, 0); }
+
+    /**
+     * As load(save), but make the new BufferData at least 'min_size'
+     * characters, so that a long run of data that is known to be coming
+     * can be read without reloading it several times.
+     */
+    bool load(char*& save, size_t min_size);
 
     inline size_t size() const { return m_data.size(); }
 
@@ -292,30 +306,63 @@ class EXPORT_MAEPARSER TokenBufferList
         }
     };
 
+    /**
+     * The position of a collected token in its buffer. Offsets are relative
+     * to the start of the buffer, and buffers are far smaller than 4 GB, so
+     * 32 bits are enough. Keeping the offset and length together means that
+     * reading a token touches a single 8 byte entry.
+     */
+    struct TokenIndex {
+        uint32_t begin;
+        uint32_t length;
+    };
+
   private:
     /// List of TokenBuffer objects.
     std::list<TokenBuffer> m_token_buffer_list;
 
-    /// Buffer indices for the beginnings of collected tokens.
-    std::vector<size_t> m_begin;
-
-    /// Buffer indices for one past the end of collected tokens.
-    std::vector<size_t> m_end;
+    /// The positions of the collected tokens.
+    std::vector<TokenIndex> m_tokens;
 
   public:
-    TokenBufferList() : m_token_buffer_list(), m_begin(), m_end() {}
+    TokenBufferList() : m_token_buffer_list(), m_tokens() {}
 
-    void reserve(size_t size)
+    void reserve(size_t size) { m_tokens.reserve(size); }
+
+    /**
+     * Return the number of collected tokens.
+     */
+    size_t size() const { return m_tokens.size(); }
+
+    /**
+     * Return the number of bytes allocated for the token index.
+     */
+    size_t indexCapacityBytes() const
     {
-        m_begin.reserve(size);
-        m_end.reserve(size);
+        return m_tokens.capacity() * sizeof(TokenIndex);
     }
 
+    /**
+     * Record a token's buffer offsets. Throws std::out_of_range if the
+     * buffer is too large for the token index.
+     */
     inline void setTokenIndices(size_t begin, size_t end)
     {
-        m_begin.push_back(begin);
-        m_end.push_back(end);
-        m_token_buffer_list.back().last_value = m_end.size();
+        if (end > std::numeric_limits<uint32_t>::max()) {
+            throw std::out_of_range("Token offset too large for the index.");
+        }
+        m_tokens.push_back({static_cast<uint32_t>(begin),
+                            static_cast<uint32_t>(end - begin)});
+        m_token_buffer_list.back().last_value = m_tokens.size();
+    }
+
+    /**
+     * Record the positions of tokens in the last buffer, in order.
+     */
+    void appendTokenIndices(const std::vector<TokenIndex>& tokens)
+    {
+        m_tokens.insert(m_tokens.end(), tokens.begin(), tokens.end());
+        m_token_buffer_list.back().last_value = m_tokens.size();
     }
 
     void appendBufferData(const BufferData& buffer_data);
@@ -329,6 +376,18 @@ class EXPORT_MAEPARSER TokenBufferList
      */
     void getData(size_t index, const char** const data,
                  size_t* const length) const;
+
+    using const_iterator = std::list<TokenBuffer>::const_iterator;
+
+    const_iterator begin() const { return m_token_buffer_list.begin(); }
+
+    /**
+     * Return token data as getData() does, searching for the token's buffer
+     * from 'buffer' rather than from the first buffer, and updating it. This
+     * avoids repeating the search when reading tokens in increasing order.
+     */
+    void getData(size_t index, const char** const data, size_t* const length,
+                 const_iterator& buffer) const;
 };
 
 /**
@@ -0,0 +1,45 @@
+#include "Coordinates.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace schrodinger
+{
+namespace mae
+{
+
+namespace
+{
+const size_t doubles_per_line = Coordinates::ALIGNMENT / sizeof(double);
+
+inline size_t round_up(size_t count)
+{
+    return (count + doubles_per_line - 1) / doubles_per_line *
+           doubles_per_line;
+}
+} // namespace
+
+Coordinates::Coordinates(size_t size, CoordinateLayout layout,
+                         std::shared_ptr<Arena> arena)
+    : m_arena(std::move(arena)), m_size(size),
+      m_stride(layout == CoordinateLayout::SOA ? round_up(size) : 1),
+      m_layout(layout)
+{
+    const size_t count =
+        layout == CoordinateLayout::SOA ? 3 * m_stride : round_up(3 * size);
+    const size_t bytes = std::max<size_t>(count, 1) * sizeof(double);
+    if (m_arena != nullptr) {
+        m_data = static_cast<double*>(m_arena->allocate(bytes, ALIGNMENT));
+    } else {
+        m_storage.reset(new char[bytes + ALIGNMENT - 1]);
+        const auto address = reinterpret_cast<std::uintptr_t>(m_storage.get());
+        const auto misalignment = address & (ALIGNMENT - 1);
+        m_data = reinterpret_cast<double*>(
+            m_storage.get() + (misalignment ? ALIGNMENT - misalignment : 0));
+    }
+    std::fill(m_data, m_data + count, 0.0);
+}
+
+} // namespace mae
+} // namespace schrodinger
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+
+#include "Arena.hpp"
+#include "MaeParserConfig.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+/**
+ * How the values of a Coordinates buffer are ordered.
+ */
+enum class CoordinateLayout {
+    SOA,    ///< Every x value, then every y value, then every z value.
+    PACKED, ///< The x, y and z values of each atom in turn.
+};
+
+/**
+ * A contiguous, aligned buffer of atom coordinates.
+ *
+ * The buffer starts on an ALIGNMENT byte boundary. In the SOA layout each of
+ * the x, y and z arrays also starts on such a boundary, and is padded with
+ * zeros up to the next one, so vectorized loops can process whole registers
+ * without a remainder loop. In the PACKED layout the values of atom i are at
+ * data()[3 * i], data()[3 * i + 1] and data()[3 * i + 2].
+ */
+class EXPORT_MAEPARSER Coordinates
+{
+  private:
+    std::shared_ptr<Arena> m_arena;
+    std::unique_ptr<char[]> m_storage;
+    double* m_data{nullptr};
+    size_t m_size;
+    size_t m_stride;
+    CoordinateLayout m_layout;
+
+  public:
+    static const size_t ALIGNMENT = 64;
+
+    /**
+     * Create a zeroed buffer for 'size' atoms, allocated from the provided
+     * Arena, or from the heap if it is null.
+     */
+    explicit Coordinates(size_t size,
+                         CoordinateLayout layout = CoordinateLayout::SOA,
+                         std::shared_ptr<Arena> arena = nullptr);
+
+    Coordinates(const Coordinates&) = delete;
+    Coordinates& operator=(const Coordinates&) = delete;
+
+    size_t size() const { return m_size; }
+
+    CoordinateLayout layout() const { return m_layout; }
+
+    /**
+     * Return the number of doubles between the first value of one axis and
+     * the first value of the next: the padded size for SOA, or 1 for PACKED.
+     */
+    size_t stride() const { return m_stride; }
+
+    /**
+     * Return the number of doubles between consecutive values of an axis:
+     * 1 for SOA, or 3 for PACKED.
+     */
+    size_t increment() const
+    {
+        return m_layout == CoordinateLayout::SOA ? 1 : 3;
+    }
+
+    double* data() { return m_data; }
+
+    const double* data() const { return m_data; }
+
+    /**
+     * Return the first value of an axis; 0 for x, 1 for y and 2 for z.
+     */
+    double* axis(size_t axis)
+    {
+        assert(axis < 3);
+        return m_data + axis * m_stride;
+    }
+
+    const double* axis(size_t axis) const
+    {
+        assert(axis < 3);
+        return m_data + axis * m_stride;
+    }
+
+    const double* x() const { return axis(0); }
+
+    const double* y() const { return axis(1); }
+
+    const double* z() const { return axis(2); }
+
+    double& operator()(size_t atom, size_t axis)
+    {
+        assert(atom < m_size);
+        return this->axis(axis)[atom * increment()];
+    }
+
+    double operator()(size_t atom, size_t axis) const
+    {
+        assert(atom < m_size);
+        return this->axis(axis)[atom * increment()];
+    }
+};
+
+} // namespace mae
+} // namespace schrodinger
@@ -1,8 +1,17 @@
 #include "MaeBlock.hpp"
 #include <cmath>
+#include <functional>
+#include <limits>
+#include <unordered_map>
 #include <utility>
 
+#include <boost/functional/hash.hpp>
+
+#include "MaeConstants.hpp"
+#include "BondAdjacency.hpp"
 #include "MaeParser.hpp"
+#include "SpatialGrid.hpp"
+#include "StructureView.hpp"
 
 using namespace std;
 
@@ -15,6 +24,13 @@ namespace
 {
 const double tolerance = 0.00001; // Tolerance to match string cutoff
 
+struct StringViewHash {
+    size_t operator()(const boost::string_view& s) const
+    {
+        return boost::hash_range(s.begin(), s.end());
+    }
+};
+
 // Wrap to-string to allow it to take strings and be a no-op
 template <typename T> inline string local_to_string(T val)
 {
@@ -26,7 +42,7 @@ inline bool char_requires_escaping(char c)
     return c == '"' || c == '\\';
 }
 
-string local_to_string(const string& val)
+string local_to_string(boost::string_view val)
 {
     if (val.empty()) {
         return R"("")";
@@ -43,7 +59,7 @@ string local_to_string(const string& val)
     }
 
     if (!quotes_required) {
-        return val;
+        return val.to_string();
     }
 
     std::stringstream new_string;
@@ -59,9 +75,14 @@ string local_to_string(const string& val)
     return new_string.str();
 }
 
+string local_to_string(const string& val)
+{
+    return local_to_string(boost::string_view(val));
+}
+
 template <typename T>
 inline void output_property_names(ostream& out, const string& indentation,
-                                  const map<string, T>& properties)
+                                  const map<InternedName, T>& properties)
 {
     for (const auto& p : properties) {
         out << indentation << p.first << "\n";
@@ -70,42 +91,252 @@ inline void output_property_names(ostream& out, const string& indentation,
 
 template <typename T>
 inline void output_property_values(ostream& out, const string& indentation,
-                                   const map<string, T>& properties)
+                                   const map<InternedName, T>& properties)
 {
     for (const auto& p : properties) {
         out << indentation << local_to_string(p.second) << "\n";
     }
 }
 
+template <typename T>
+inline void output_property_names(ostream& out, const string& indentation,
+                                  const PropertyMap<T>& properties)
+{
+    output_property_names(out, indentation, sorted_properties(properties));
+}
+
+template <typename T>
+inline void output_property_values(ostream& out, const string& indentation,
+                                   const PropertyMap<T>& properties)
+{
+    output_property_values(out, indentation, sorted_properties(properties));
+}
+
 template <typename T>
 void output_indexed_property_values(ostream& out,
-                                    const map<string, T>& properties,
+                                    const map<InternedName, T>& properties,
                                     unsigned int index)
 {
     for (const auto& p : properties) {
-        const auto& property = p.second;
-        if (property->isDefined(index)) {
-            out << ' ' << local_to_string(property->at(index));
+        // Read through a const reference so compact encodings stay compact.
+        const auto& property = *p.second;
+        if (property.isDefined(index)) {
+            out << ' ' << local_to_string(property.at(index));
         } else {
             out << " <>";
         }
     }
 }
 
+/**
+ * A string column of an IndexedBlock, however it is stored, so that it can
+ * be written and compared without copying its values.
+ */
+class StringColumn
+{
+  private:
+    const IndexedStringProperty* m_strings;
+    const IndexedStringViewProperty* m_views;
+
+  public:
+    explicit StringColumn(const IndexedStringProperty* strings)
+        : m_strings(strings), m_views(nullptr)
+    {
+    }
+
+    explicit StringColumn(const IndexedStringViewProperty* views)
+        : m_strings(nullptr), m_views(views)
+    {
+    }
+
+    size_t size() const
+    {
+        return m_strings ? m_strings->size() : m_views->size();
+    }
+
+    bool isDefined(size_t index) const
+    {
+        return m_strings ? m_strings->isDefined(index)
+                         : m_views->isDefined(index);
+    }
+
+    boost::string_view at(size_t index) const
+    {
+        return m_strings ? boost::string_view(m_strings->at(index))
+                         : m_views->at(index);
+    }
+
+    bool operator==(const StringColumn& rhs) const
+    {
+        if (size() != rhs.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < size(); ++i) {
+            if (isDefined(i) != rhs.isDefined(i)) {
+                return false;
+            }
+            if (isDefined(i) && at(i) != rhs.at(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * Return the string columns stored either way, ordered by name.
+ */
+map<InternedName, StringColumn> string_columns(
+    const PropertyMap<shared_ptr<IndexedStringProperty>>& strings,
+    const PropertyMap<shared_ptr<IndexedStringViewProperty>>& views)
+{
+    map<InternedName, StringColumn> columns;
+    for (const auto& p : strings) {
+        columns.emplace(p.first, StringColumn(p.second.get()));
+    }
+    for (const auto& p : views) {
+        columns.emplace(p.first, StringColumn(p.second.get()));
+    }
+    return columns;
+}
+
+void output_indexed_property_values(
+    ostream& out, const map<InternedName, StringColumn>& columns,
+    unsigned int index)
+{
+    for (const auto& p : columns) {
+        const auto& column = p.second;
+        if (column.isDefined(index)) {
+            out << ' ' << local_to_string(column.at(index));
+        } else {
+            out << " <>";
+        }
+    }
+}
+
+template <typename T, typename Equal>
+bool indexed_values_equal(const IndexedProperty<T>& lhs,
+                          const IndexedProperty<T>& rhs, Equal equal)
+{
+    if (lhs.size() != rhs.size())
+        return false;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs.isDefined(i) != rhs.isDefined(i))
+            return false;
+        if (lhs.isDefined(i) && !equal(lhs.get(i), rhs.get(i)))
+            return false;
+    }
+    return true;
+}
+
 template <typename T>
 bool maps_indexed_props_equal(const T& lmap, const T& rmap)
 {
     if (rmap.size() != lmap.size())
         return false;
-    auto diff = std::mismatch(
-        lmap.begin(), lmap.end(), rmap.begin(),
-        [](decltype(*begin(lmap)) l, decltype(*begin(lmap)) r) {
-            return l.first == r.first && *(l.second) == *(r.second);
-        });
-    if (diff.first != lmap.end())
+    for (const auto& p : lmap) {
+        auto iter = rmap.find(p.first);
+        if (iter == rmap.end() || !(*(p.second) == *(iter->second)))
+            return false;
+    }
+    return true;
+}
+template <typename T>
+bool identical_values(const IndexedProperty<T>& lhs,
+                      const IndexedProperty<T>& rhs)
+{
+    return indexed_values_equal(
+        lhs, rhs, [](const T& a, const T& b) { return same_value(a, b); });
+}
+
+bool identical_values(const IndexedStringViewProperty& lhs,
+                      const IndexedStringViewProperty& rhs)
+{
+    return lhs == rhs;
+}
+
+/**
+ * Copy the columns of 'columns' into 'shared', taking those that are
+ * identical to a column of 'previous' from 'previous'. Every column
+ * stored in 'shared' is then held by two blocks and is marked as shared.
+ */
+template <typename Map>
+void share_columns(const Map& columns, const Map* previous, Map& shared)
+{
+    for (const auto& column : columns) {
+        auto value = column.second;
+        if (previous != nullptr) {
+            auto iter = previous->find(column.first);
+            if (iter != previous->end() &&
+                (iter->second == value ||
+                 identical_values(*value, *iter->second))) {
+                value = iter->second;
+            }
+        }
+        value->markShared();
+        shared.emplace(column.first, std::move(value));
+    }
+}
+
+template <typename Map>
+bool share_column(const Map& other, InternedName name, Map& shared)
+{
+    auto iter = other.find(name);
+    if (iter == other.end()) {
         return false;
+    }
+    iter->second->markShared();
+    shared[name] = iter->second;
     return true;
 }
+
+/**
+ * Replace each shared column of 'columns' by a dense copy that belongs
+ * to 'arena'. Reads through get() so that the shared column isn't
+ * expanded.
+ */
+template <typename T>
+void unshare_columns(PropertyMap<std::shared_ptr<IndexedProperty<T>>>& columns,
+                     const std::shared_ptr<Arena>& arena)
+{
+    for (auto& column : columns) {
+        const auto& property = *column.second;
+        if (!property.isShared()) {
+            continue;
+        }
+        std::vector<T> values;
+        values.reserve(property.size());
+        for (size_t i = 0; i < property.size(); ++i) {
+            values.push_back(property.get(i, T()));
+        }
+        column.second = allocate_shared_in<IndexedProperty<T>>(
+            arena, values, property.validity());
+    }
+}
+
+void unshare_columns(
+    PropertyMap<std::shared_ptr<IndexedStringViewProperty>>& columns,
+    const std::shared_ptr<Arena>& arena)
+{
+    for (auto& column : columns) {
+        const auto& property = *column.second;
+        if (!property.isShared()) {
+            continue;
+        }
+        auto copy = allocate_shared_in<IndexedStringViewProperty>(arena);
+        for (size_t i = 0; i < property.size(); ++i) {
+            if (property.isDefined(i)) {
+                copy->push_back(property[i]);
+            } else {
+                copy->push_back_undefined();
+            }
+        }
+        if (property.isDictionaryEncoded()) {
+            copy->dictionaryEncode();
+        }
+        column.second = std::move(copy);
+    }
+}
 } // namespace
 
 void Block::write(ostream& out, unsigned int current_indentation) const
@@ -170,8 +401,40 @@ shared_ptr<const IndexedBlock> Block::getIndexedBlock(const string& name) const
         m_indexed_block_map->getIndexedBlock(name));
 }
 
-bool real_map_equal(const map<string, double>& rmap1,
-                    const map<string, double>& rmap2)
+shared_ptr<const IndexedBlock> Block::getIndexedBlock(InternedName name) const
+{
+    if (!hasIndexedBlockData()) {
+        throw out_of_range("Indexed block not found: " + name.str());
+    }
+    return m_indexed_block_map->getIndexedBlock(name);
+}
+
+shared_ptr<const StructureView> Block::getStructureView() const
+{
+    if (m_structure_view != nullptr) {
+        return m_structure_view;
+    }
+    return allocate_shared_in<StructureView>(getArena(), *this);
+}
+
+shared_ptr<const BondAdjacency> Block::getBondAdjacency() const
+{
+    if (m_bond_adjacency != nullptr) {
+        return m_bond_adjacency;
+    }
+    return allocate_shared_in<BondAdjacency>(getArena(), *this);
+}
+
+shared_ptr<const SpatialGrid> Block::getSpatialGrid() const
+{
+    if (m_spatial_grid != nullptr) {
+        return m_spatial_grid;
+    }
+    return allocate_shared_in<SpatialGrid>(getArena(), *this);
+}
+
+bool real_map_equal(const PropertyMap<double>& rmap1,
+                    const PropertyMap<double>& rmap2)
 {
     if (rmap1.size() != rmap2.size())
         return false;
@@ -216,15 +479,50 @@ bool IndexedBlockMapI::operator==(const IndexedBlockMapI& rhs) const
     return true;
 }
 
+bool IndexedBlockMapI::getIntColumn(InternedName block, InternedName column,
+                                    vector<int>& values) const
+{
+    if (!hasIndexedBlock(block)) {
+        return false;
+    }
+    const auto property = getIndexedBlock(block)->getIntProperty(column);
+    if (property == nullptr) {
+        return false;
+    }
+    const IndexedIntProperty& ints = *property;
+    values.clear();
+    values.reserve(ints.size());
+    for (size_t i = 0; i < ints.size(); ++i) {
+        values.push_back(ints.get(i, 0));
+    }
+    return true;
+}
+
+shared_ptr<const Coordinates>
+IndexedBlockMapI::getCoordinates(InternedName block,
+                                 CoordinateLayout layout) const
+{
+    if (!hasIndexedBlock(block)) {
+        return nullptr;
+    }
+    return getIndexedBlock(block)->getCoordinates(layout);
+}
+
+size_t IndexedBlockMapI::getRowCount(InternedName block) const
+{
+    return hasIndexedBlock(block) ? getIndexedBlock(block)->size() : 0;
+}
+
 bool IndexedBlockMap::hasIndexedBlock(const string& name) const
 {
-    return m_indexed_block.find(name) != m_indexed_block.end();
+    return has_property(m_indexed_block, name);
 }
 
 shared_ptr<const IndexedBlock>
 IndexedBlockMap::getIndexedBlock(const string& name) const
 {
-    auto block_iter = m_indexed_block.find(name);
+    const auto key = NameTable::find(name);
+    auto block_iter = key ? m_indexed_block.find(key) : m_indexed_block.end();
     if (block_iter != m_indexed_block.end()) {
         return const_pointer_cast<const IndexedBlock>(block_iter->second);
     } else {
@@ -232,11 +530,26 @@ IndexedBlockMap::getIndexedBlock(const string& name) const
     }
 }
 
+bool IndexedBlockMap::hasIndexedBlock(InternedName name) const
+{
+    return has_property(m_indexed_block, name);
+}
+
+shared_ptr<const IndexedBlock>
+IndexedBlockMap::getIndexedBlock(InternedName name) const
+{
+    auto block_iter = m_indexed_block.find(name);
+    if (block_iter == m_indexed_block.end()) {
+        throw out_of_range("Indexed block not found: " + name.str());
+    }
+    return block_iter->second;
+}
+
 bool BufferedIndexedBlockMap::hasIndexedBlock(const string& name) const
 {
-    if (m_indexed_buffer.find(name) != m_indexed_buffer.end()) {
+    if (has_property(m_indexed_buffer, name)) {
         return true;
-    } else if (m_indexed_block.find(name) != m_indexed_block.end()) {
+    } else if (has_property(m_indexed_block, name)) {
         return true;
     } else {
         return false;
@@ -245,6 +558,22 @@ bool BufferedIndexedBlockMap::hasIndexedBlock(const string& name) const
 
 shared_ptr<const IndexedBlock>
 BufferedIndexedBlockMap::getIndexedBlock(const string& name) const
+{
+    const auto key = NameTable::find(name);
+    if (!key) {
+        throw out_of_range("Indexed block not found: " + name);
+    }
+    return getIndexedBlock(key);
+}
+
+bool BufferedIndexedBlockMap::hasIndexedBlock(InternedName name) const
+{
+    return has_property(m_indexed_buffer, name) ||
+           has_property(m_indexed_block, name);
+}
+
+shared_ptr<const IndexedBlock>
+BufferedIndexedBlockMap::getIndexedBlock(InternedName name) const
 {
     auto itb = m_indexed_block.find(name);
     if (itb != m_indexed_block.end()) {
@@ -253,45 +582,268 @@ BufferedIndexedBlockMap::getIndexedBlock(const string& name) const
 
     auto itbb = m_indexed_buffer.find(name);
     if (itbb == m_indexed_buffer.end()) {
-        throw out_of_range("Indexed block not found: " + name);
-    } else {
-        shared_ptr<const IndexedBlock> ib(itbb->second->getIndexedBlock());
-        return ib;
+        throw out_of_range("Indexed block not found: " + name.str());
+    }
+
+    std::lock_guard<std::mutex> lock(m_materialized_mutex);
+    auto& materialized = m_materialized[name];
+    if (materialized == nullptr) {
+        materialized = itbb->second->getIndexedBlock(
+            m_indexed_buffer.get_allocator().arena());
+    }
+    return materialized;
+}
+
+bool BufferedIndexedBlockMap::getIntColumn(InternedName block,
+                                           InternedName column,
+                                           vector<int>& values) const
+{
+    auto itbb = m_indexed_buffer.find(block);
+    if (has_property(m_indexed_block, block) ||
+        itbb == m_indexed_buffer.end()) {
+        return IndexedBlockMapI::getIntColumn(block, column, values);
+    }
+    return itbb->second->getIntColumn(column, values);
+}
+
+shared_ptr<const Coordinates>
+BufferedIndexedBlockMap::getCoordinates(InternedName block,
+                                        CoordinateLayout layout) const
+{
+    auto itbb = m_indexed_buffer.find(block);
+    if (has_property(m_indexed_block, block) ||
+        itbb == m_indexed_buffer.end()) {
+        return IndexedBlockMapI::getCoordinates(block, layout);
+    }
+    return itbb->second->getCoordinates(
+        layout, m_indexed_buffer.get_allocator().arena());
+}
+
+shared_ptr<const IndexedBlockBuffer>
+BufferedIndexedBlockMap::getIndexedBlockBuffer(InternedName block) const
+{
+    auto itbb = m_indexed_buffer.find(block);
+    if (has_property(m_indexed_block, block) ||
+        itbb == m_indexed_buffer.end()) {
+        return nullptr;
+    }
+    return itbb->second;
+}
+
+size_t BufferedIndexedBlockMap::getRowCount(InternedName block) const
+{
+    auto itbb = m_indexed_buffer.find(block);
+    if (has_property(m_indexed_block, block) ||
+        itbb == m_indexed_buffer.end()) {
+        return IndexedBlockMapI::getRowCount(block);
     }
+    return itbb->second->size();
 }
 
 template <>
 EXPORT_MAEPARSER void
-IndexedBlock::setProperty<BoolProperty>(const string& name,
+IndexedBlock::setProperty<BoolProperty>(InternedName name,
                                         shared_ptr<IndexedBoolProperty> value)
 {
-    set_indexed_property<IndexedBoolProperty>(m_bmap, name, std::move(value));
+    m_bmap[name] = std::move(value);
 }
 
 template <>
 EXPORT_MAEPARSER void
-IndexedBlock::setProperty<double>(const string& name,
+IndexedBlock::setProperty<double>(InternedName name,
                                   shared_ptr<IndexedProperty<double>> value)
 {
-    set_indexed_property<IndexedProperty<double>>(m_rmap, name,
-                                                  std::move(value));
+    m_rmap[name] = std::move(value);
+    realPropertyChanged(name);
 }
 
 template <>
 EXPORT_MAEPARSER void
-IndexedBlock::setProperty<int>(const string& name,
+IndexedBlock::setProperty<int>(InternedName name,
                                shared_ptr<IndexedProperty<int>> value)
 {
-    set_indexed_property<IndexedProperty<int>>(m_imap, name, std::move(value));
+    m_imap[name] = std::move(value);
 }
 
 template <>
 EXPORT_MAEPARSER void
-IndexedBlock::setProperty<string>(const string& name,
+IndexedBlock::setProperty<string>(InternedName name,
                                   shared_ptr<IndexedProperty<string>> value)
 {
-    set_indexed_property<IndexedProperty<string>>(m_smap, name,
-                                                  std::move(value));
+    setStringProperty(name, std::move(value));
+}
+
+void IndexedBlock::setStringProperty(InternedName key,
+                                     shared_ptr<IndexedStringProperty> value)
+{
+    m_svmap.erase(key);
+    m_smap[key] = std::move(value);
+}
+
+shared_ptr<IndexedStringProperty>
+IndexedBlock::getStringProperty(InternedName key) const
+{
+    auto iter = m_smap.find(key);
+    if (iter != m_smap.end()) {
+        return iter->second;
+    }
+    // Materialize a string view column once, storing the copy in its place
+    // so that changes made to it are kept.
+    auto view_iter = m_svmap.find(key);
+    if (view_iter != m_svmap.end()) {
+        auto property = view_iter->second->toStringProperty();
+        m_svmap.erase(view_iter);
+        m_smap[key] = property;
+        return property;
+    }
+    return nullptr;
+}
+
+shared_ptr<IndexedStringViewProperty>
+IndexedBlock::getStringViewProperty(InternedName key) const
+{
+    auto view_iter = m_svmap.find(key);
+    if (view_iter != m_svmap.end()) {
+        return view_iter->second;
+    }
+    auto iter = m_smap.find(key);
+    if (iter != m_smap.end()) {
+        return allocate_shared_in<IndexedStringViewProperty>(getArena(),
+                                                             *iter->second);
+    }
+    return nullptr;
+}
+
+void IndexedBlock::setStringViewProperty(
+    InternedName key, shared_ptr<IndexedStringViewProperty> value)
+{
+    m_smap.erase(key);
+    m_svmap[key] = std::move(value);
+}
+
+int coordinate_axis(InternedName name)
+{
+    static const PropertyKey axes[] = {PropertyKey(ATOM_X_COORD),
+                                       PropertyKey(ATOM_Y_COORD),
+                                       PropertyKey(ATOM_Z_COORD)};
+    for (int axis = 0; axis < 3; ++axis) {
+        if (name == axes[axis]) {
+            return axis;
+        }
+    }
+    return -1;
+}
+
+void IndexedBlock::realPropertyChanged(InternedName name)
+{
+    if (m_coordinates != nullptr && coordinate_axis(name) >= 0) {
+        m_coordinates = nullptr;
+    }
+}
+
+shared_ptr<const Coordinates>
+IndexedBlock::getCoordinates(CoordinateLayout layout) const
+{
+    if (m_coordinates != nullptr && m_coordinates->layout() == layout) {
+        return m_coordinates;
+    }
+
+    const PropertyKey keys[] = {PropertyKey(ATOM_X_COORD),
+                                PropertyKey(ATOM_Y_COORD),
+                                PropertyKey(ATOM_Z_COORD)};
+    shared_ptr<const IndexedRealProperty> columns[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        columns[axis] = getRealProperty(keys[axis]);
+        if (columns[axis] == nullptr) {
+            return nullptr;
+        }
+    }
+    const size_t size = columns[0]->size();
+    if (columns[1]->size() != size || columns[2]->size() != size) {
+        throw std::runtime_error("Coordinate columns differ in size.");
+    }
+
+    const auto arena = getArena();
+    auto coordinates =
+        allocate_shared_in<Coordinates>(arena, size, layout, arena);
+    const double undefined = std::numeric_limits<double>::quiet_NaN();
+    const size_t increment = coordinates->increment();
+    for (int axis = 0; axis < 3; ++axis) {
+        const auto& column = *columns[axis];
+        double* values = coordinates->axis(axis);
+        for (size_t i = 0; i < size; ++i) {
+            values[i * increment] = column.get(i, undefined);
+        }
+    }
+    return coordinates;
+}
+
+shared_ptr<IndexedBlock>
+IndexedBlock::shareColumns(const IndexedBlock* previous) const
+{
+    const auto arena = getArena();
+    auto shared = allocate_shared_in<IndexedBlock>(arena, m_name, arena);
+    share_columns(m_bmap, previous ? &previous->m_bmap : nullptr,
+                  shared->m_bmap);
+    share_columns(m_imap, previous ? &previous->m_imap : nullptr,
+                  shared->m_imap);
+    share_columns(m_rmap, previous ? &previous->m_rmap : nullptr,
+                  shared->m_rmap);
+    share_columns(m_smap, previous ? &previous->m_smap : nullptr,
+                  shared->m_smap);
+    share_columns(m_svmap, previous ? &previous->m_svmap : nullptr,
+                  shared->m_svmap);
+    shared->m_coordinates = m_coordinates;
+    return shared;
+}
+
+bool IndexedBlock::shareColumn(const IndexedBlock& other, InternedName name)
+{
+    switch (name[0]) {
+    case 'b':
+        return share_column(other.m_bmap, name, m_bmap);
+    case 'i':
+        return share_column(other.m_imap, name, m_imap);
+    case 'r':
+        if (share_column(other.m_rmap, name, m_rmap)) {
+            realPropertyChanged(name);
+            return true;
+        }
+        return false;
+    case 's':
+        if (share_column(other.m_smap, name, m_smap)) {
+            m_svmap.erase(name);
+            return true;
+        } else if (share_column(other.m_svmap, name, m_svmap)) {
+            m_smap.erase(name);
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+void IndexedBlock::unshareColumns()
+{
+    const auto arena = getArena();
+    unshare_columns(m_bmap, arena);
+    unshare_columns(m_imap, arena);
+    unshare_columns(m_rmap, arena);
+    unshare_columns(m_smap, arena);
+    unshare_columns(m_svmap, arena);
+}
+
+map<InternedName, shared_ptr<IndexedStringProperty>>
+IndexedBlock::sortedStringProperties() const
+{
+    vector<InternedName> views;
+    for (const auto& p : m_svmap) {
+        views.push_back(p.first);
+    }
+    for (const auto& name : views) {
+        getStringProperty(name);
+    }
+    return sorted_properties(m_smap);
 }
 
 size_t IndexedBlock::size() const
@@ -307,6 +859,8 @@ size_t IndexedBlock::size() const
         count = max(p.second->size(), count);
     for (const auto& p : m_smap)
         count = max(p.second->size(), count);
+    for (const auto& p : m_svmap)
+        count = max(p.second->size(), count);
 
     return count;
 }
@@ -317,27 +871,33 @@ void IndexedBlock::write(ostream& out, unsigned int current_indentation) const
     string indentation = string(current_indentation + 2, ' ');
 
     const bool has_data = !m_bmap.empty() || !m_rmap.empty() ||
-                          !m_imap.empty() || !m_smap.empty();
+                          !m_imap.empty() || !m_smap.empty() ||
+                          !m_svmap.empty();
 
     out << root_indentation << getName() << "[" << to_string((int) size())
         << "] {\n";
 
     if (has_data) {
+        const auto bmap = sorted_properties(m_bmap);
+        const auto rmap = sorted_properties(m_rmap);
+        const auto imap = sorted_properties(m_imap);
+        const auto smap = string_columns(m_smap, m_svmap);
+
         out << indentation + "# First column is Index #\n";
 
-        output_property_names(out, indentation, m_bmap);
-        output_property_names(out, indentation, m_rmap);
-        output_property_names(out, indentation, m_imap);
-        output_property_names(out, indentation, m_smap);
+        output_property_names(out, indentation, bmap);
+        output_property_names(out, indentation, rmap);
+        output_property_names(out, indentation, imap);
+        output_property_names(out, indentation, smap);
 
         out << indentation + ":::\n";
 
         for (unsigned int i = 0; i < size(); ++i) {
             out << indentation << i + 1;
-            output_indexed_property_values(out, m_bmap, i);
-            output_indexed_property_values(out, m_rmap, i);
-            output_indexed_property_values(out, m_imap, i);
-            output_indexed_property_values(out, m_smap, i);
+            output_indexed_property_values(out, bmap, i);
+            output_indexed_property_values(out, rmap, i);
+            output_indexed_property_values(out, imap, i);
+            output_indexed_property_values(out, smap, i);
             out << endl;
         }
 
@@ -357,37 +917,36 @@ string IndexedBlock::toString() const
     return stream.str();
 }
 
-template <typename T>
-bool IndexedProperty<T>::operator==(const IndexedProperty<T>& rhs) const
+template <>
+EXPORT_MAEPARSER bool IndexedProperty<BoolProperty>::operator==(
+    const IndexedProperty<BoolProperty>& rhs) const
 {
-    if (m_is_null == nullptr || rhs.m_is_null == nullptr) {
-        if ((m_is_null == nullptr) != (rhs.m_is_null == nullptr))
-            return false;
-    } else if (*m_is_null != *(rhs.m_is_null)) {
-        return false;
-    }
-    if (m_data != rhs.m_data)
-        return false;
-    return true;
+    return indexed_values_equal(*this, rhs, equal_to<BoolProperty>());
+}
+
+template <>
+EXPORT_MAEPARSER bool
+IndexedProperty<int>::operator==(const IndexedProperty<int>& rhs) const
+{
+    return indexed_values_equal(*this, rhs, equal_to<int>());
 }
 
 // For doubles we need to implement our own comparator for the vectors to
 // take precision into account
 template <>
-bool IndexedProperty<double>::operator==(
-    const IndexedProperty<double>& rhs) const
+EXPORT_MAEPARSER bool
+IndexedProperty<double>::operator==(const IndexedProperty<double>& rhs) const
 {
-    if (m_is_null == nullptr || rhs.m_is_null == nullptr) {
-        if ((m_is_null == nullptr) != (rhs.m_is_null == nullptr))
-            return false;
-    } else if (*m_is_null != *(rhs.m_is_null))
-        return false;
-
-    for (size_t i = 0; i < m_data.size(); ++i)
-        if ((float) abs(m_data[i] - rhs.m_data[i]) > tolerance)
-            return false;
+    return indexed_values_equal(*this, rhs, [](double lhs, double rhs) {
+        return (float) abs(lhs - rhs) <= tolerance;
+    });
+}
 
-    return true;
+template <>
+EXPORT_MAEPARSER bool IndexedProperty<string>::operator==(
+    const IndexedProperty<string>& rhs) const
+{
+    return indexed_values_equal(*this, rhs, equal_to<string>());
 }
 
 bool IndexedBlock::operator==(const IndexedBlock& rhs) const
@@ -398,9 +957,179 @@ bool IndexedBlock::operator==(const IndexedBlock& rhs) const
         return false;
     if (!maps_indexed_props_equal(m_rmap, rhs.m_rmap))
         return false;
-    if (!maps_indexed_props_equal(m_smap, rhs.m_smap))
+    if (m_svmap.empty() && rhs.m_svmap.empty()) {
+        return maps_indexed_props_equal(m_smap, rhs.m_smap);
+    }
+    // Compare string columns by value, however they are stored.
+    return string_columns(m_smap, m_svmap) ==
+           string_columns(rhs.m_smap, rhs.m_svmap);
+}
+
+IndexedStringViewProperty::IndexedStringViewProperty(
+    const IndexedStringProperty& property)
+    : IndexedStringViewProperty()
+{
+    const auto& values = property.data();
+    size_t chars = 0;
+    for (const auto& value : values) {
+        chars += value.size();
+    }
+    reserve(values.size(), chars);
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (property.isDefined(i)) {
+            push_back(values[i]);
+        } else {
+            push_back_undefined();
+        }
+    }
+}
+
+void IndexedStringViewProperty::reserve(size_type values, size_t chars)
+{
+    m_offsets.reserve(values + 1);
+    m_chars.reserve(chars);
+}
+
+const uint16_t IndexedStringViewProperty::UNDEFINED_CODE;
+
+void IndexedStringViewProperty::checkWritable() const
+{
+    if (m_shared) {
+        throw logic_error("Indexed property is shared between blocks; see "
+                          "IndexedBlock::unshareColumns().");
+    }
+}
+
+void IndexedStringViewProperty::checkAppendable() const
+{
+    checkWritable();
+    if (m_dictionary_encoded) {
+        throw runtime_error("Can't append to a dictionary encoded column.");
+    }
+}
+
+void IndexedStringViewProperty::appendOffset()
+{
+    if (m_chars.size() > numeric_limits<uint32_t>::max()) {
+        throw length_error("String column exceeds 4 GiB.");
+    }
+    m_offsets.push_back(static_cast<uint32_t>(m_chars.size()));
+    if (!m_validity.empty()) {
+        m_validity.push_back(true);
+    }
+}
+
+void IndexedStringViewProperty::push_back(boost::string_view value)
+{
+    checkAppendable();
+    m_chars.insert(m_chars.end(), value.begin(), value.end());
+    appendOffset();
+}
+
+void IndexedStringViewProperty::push_back_escaped(boost::string_view value)
+{
+    const auto escape = value.find('\\');
+    if (escape == boost::string_view::npos) {
+        push_back(value);
+        return;
+    }
+    checkAppendable();
+    m_chars.insert(m_chars.end(), value.begin(), value.begin() + escape);
+    for (size_t i = escape; i < value.size(); ++i) {
+        if (value[i] == '\\' && ++i == value.size()) {
+            break;
+        }
+        m_chars.push_back(value[i]);
+    }
+    appendOffset();
+}
+
+void IndexedStringViewProperty::push_back_undefined()
+{
+    checkAppendable();
+    if (m_validity.empty()) {
+        m_validity = Bitmap(size(), true);
+    }
+    m_offsets.push_back(m_offsets.back());
+    m_validity.push_back(false);
+}
+
+bool IndexedStringViewProperty::operator==(
+    const IndexedStringViewProperty& rhs) const
+{
+    if (size() != rhs.size()) {
+        return false;
+    }
+    for (size_type i = 0; i < size(); ++i) {
+        if (isDefined(i) != rhs.isDefined(i)) {
+            return false;
+        }
+        if (isDefined(i) && operator[](i) != rhs[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+shared_ptr<IndexedStringProperty>
+IndexedStringViewProperty::toStringProperty() const
+{
+    vector<string> values;
+    values.reserve(size());
+    for (size_type i = 0; i < size(); ++i) {
+        const auto value = isDefined(i) ? operator[](i) : boost::string_view();
+        values.emplace_back(value.data(), value.size());
+    }
+    return make_shared<IndexedStringProperty>(values, m_validity);
+}
+
+bool IndexedStringViewProperty::dictionaryEncode()
+{
+    if (m_dictionary_encoded) {
+        return true;
+    }
+    checkWritable();
+
+    // The keys view the current character buffer, which is left untouched
+    // until the new one replaces it.
+    unordered_map<boost::string_view, uint16_t, StringViewHash> lookup;
+    vector<char> chars;
+    vector<uint32_t> offsets(1, 0);
+    vector<uint16_t> codes;
+    codes.reserve(size());
+    for (size_type i = 0; i < size(); ++i) {
+        if (!isDefined(i)) {
+            codes.push_back(UNDEFINED_CODE);
+            continue;
+        }
+        const auto value = entry(i);
+        auto iter = lookup.find(value);
+        if (iter == lookup.end()) {
+            if (lookup.size() == UNDEFINED_CODE) {
+                return false;
+            }
+            const auto code = static_cast<uint16_t>(lookup.size());
+            iter = lookup.emplace(value, code).first;
+            chars.insert(chars.end(), value.begin(), value.end());
+            offsets.push_back(static_cast<uint32_t>(chars.size()));
+        }
+        codes.push_back(iter->second);
+    }
+
+    const auto encoded_size = chars.size() +
+                              offsets.size() * sizeof(uint32_t) +
+                              codes.size() * sizeof(uint16_t);
+    const auto plain_size =
+        m_chars.size() + m_offsets.size() * sizeof(uint32_t);
+    if (encoded_size >= plain_size) {
         return false;
+    }
 
+    chars.shrink_to_fit();
+    m_chars.swap(chars);
+    m_offsets.swap(offsets);
+    m_codes.swap(codes);
+    m_dictionary_encoded = true;
     return true;
 }
 
@@ -1,14 +1,28 @@
 #pragma once
 
+#include <algorithm>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/utility/string_view.hpp>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "Arena.hpp"
+#include "Bitmap.hpp"
+#include "Coordinates.hpp"
 #include "MaeParserConfig.hpp"
+#include "NameTable.hpp"
 
 namespace schrodinger
 {
@@ -16,21 +30,90 @@ namespace mae
 {
 using BoolProperty = uint8_t;
 
+/**
+ * Property storage. Keys are hashed by identity, so a lookup with an
+ * InternedName or PropertyKey is constant time and never compares strings.
+ */
 template <typename T>
-inline const T& get_property(const std::map<std::string, T>& map,
-                             const std::string& name)
+using PropertyMap =
+    std::unordered_map<InternedName, T, std::hash<InternedName>,
+                       std::equal_to<InternedName>,
+                       ArenaAllocator<std::pair<const InternedName, T>>>;
+
+/**
+ * Name-ordered storage for blocks.
+ */
+template <typename T>
+using NameMap = std::map<InternedName, T, std::less<InternedName>,
+                         ArenaAllocator<std::pair<const InternedName, T>>>;
+
+template <typename Map>
+inline bool has_property(const Map& map, const std::string& name)
+{
+    // A name that was never interned can't be a key of any map.
+    const auto key = NameTable::find(name);
+    return key && map.find(key) != map.end();
+}
+
+template <typename Map>
+inline bool has_property(const Map& map, InternedName key)
+{
+    return map.find(key) != map.end();
+}
+
+template <typename T, typename Map>
+inline const T& get_property(const Map& map, InternedName key)
 {
-    auto iter = map.find(name);
+    auto iter = map.find(key);
     if (iter == map.end()) {
-        throw std::out_of_range("Key not found: " + name);
-    } else {
-        return iter->second;
+        throw std::out_of_range("Key not found: " + key.str());
+    }
+    return iter->second;
+}
+
+template <typename T, typename Map>
+inline const T& get_property(const Map& map, const std::string& name)
+{
+    const auto key = NameTable::find(name);
+    if (key) {
+        auto iter = map.find(key);
+        if (iter != map.end()) {
+            return iter->second;
+        }
+    }
+    throw std::out_of_range("Key not found: " + name);
+}
+
+/**
+ * Return a copy of a property map, ordered by name.
+ */
+template <typename T>
+inline std::map<InternedName, T> sorted_properties(const PropertyMap<T>& map)
+{
+    return std::map<InternedName, T>(map.begin(), map.end());
+}
+
+/**
+ * Return a copy of a map keyed by InternedName, keyed by std::string. Both
+ * orders are the same, so every key is inserted at the end.
+ */
+template <typename T>
+inline std::map<std::string, T>
+string_keyed(const std::map<InternedName, T>& map)
+{
+    std::map<std::string, T> copy;
+    for (const auto& p : map) {
+        copy.emplace_hint(copy.end(), p.first.str(), p.second);
     }
+    return copy;
 }
 
 // Forward declaration.
 class IndexedBlockBuffer;
 class IndexedBlock;
+class StructureView;
+class BondAdjacency;
+class SpatialGrid;
 
 class EXPORT_MAEPARSER IndexedBlockMapI
 {
@@ -42,25 +125,82 @@ class EXPORT_MAEPARSER IndexedBlockMapI
     virtual std::shared_ptr<const IndexedBlock>
     getIndexedBlock(const std::string& name) const = 0;
 
+    /**
+     * Lookups by pre-resolved name. The default implementations fall back to
+     * the string versions.
+     */
+    virtual bool hasIndexedBlock(InternedName name) const
+    {
+        return hasIndexedBlock(name.str());
+    }
+
+    virtual std::shared_ptr<const IndexedBlock>
+    getIndexedBlock(InternedName name) const
+    {
+        return getIndexedBlock(name.str());
+    }
+
     virtual std::vector<std::string> getBlockNames() const = 0;
     bool operator==(const IndexedBlockMapI& rhs) const;
+
+    /**
+     * Copy an int column of an indexed block into 'values', with undefined
+     * values as zero. Return false if there is no such block or column.
+     * The default implementation reads the column of the IndexedBlock.
+     */
+    virtual bool getIntColumn(InternedName block, InternedName column,
+                              std::vector<int>& values) const;
+
+    /**
+     * Return the coordinates of an indexed block, or null if there is no
+     * such block; see IndexedBlock::getCoordinates(). The default
+     * implementation reads the columns of the IndexedBlock.
+     */
+    virtual std::shared_ptr<const Coordinates>
+    getCoordinates(InternedName block, CoordinateLayout layout) const;
+
+    /**
+     * Return the number of rows of an indexed block, or zero if there is no
+     * such block.
+     */
+    virtual size_t getRowCount(InternedName block) const;
+
+    /**
+     * Return the buffer holding the unparsed tokens of an indexed block, or
+     * null if there is none. The default implementation returns null.
+     */
+    virtual std::shared_ptr<const IndexedBlockBuffer>
+    getIndexedBlockBuffer(InternedName /*block*/) const
+    {
+        return nullptr;
+    }
 };
 
 class EXPORT_MAEPARSER IndexedBlockMap : public IndexedBlockMapI
 {
-    std::map<std::string, std::shared_ptr<IndexedBlock>> m_indexed_block;
+    NameMap<std::shared_ptr<IndexedBlock>> m_indexed_block;
 
   public:
+    explicit IndexedBlockMap(std::shared_ptr<Arena> arena = nullptr)
+        : m_indexed_block(ArenaAllocator<char>(std::move(arena)))
+    {
+    }
+
     bool hasIndexedBlock(const std::string& name) const override;
 
     std::shared_ptr<const IndexedBlock>
     getIndexedBlock(const std::string& name) const override;
 
+    bool hasIndexedBlock(InternedName name) const override;
+
+    std::shared_ptr<const IndexedBlock>
+    getIndexedBlock(InternedName name) const override;
+
     std::vector<std::string> getBlockNames() const override
     {
         std::vector<std::string> rval;
         for (const auto& p : m_indexed_block) {
-            rval.push_back(p.first);
+            rval.push_back(p.first.str());
         }
 
         return rval;
@@ -72,32 +212,67 @@ class EXPORT_MAEPARSER IndexedBlockMap : public IndexedBlockMapI
     void addIndexedBlock(const std::string& name,
                          std::shared_ptr<IndexedBlock> indexed_block)
     {
-        m_indexed_block[name] = std::move(indexed_block);
+        m_indexed_block[NameTable::intern(name)] = std::move(indexed_block);
     }
 };
 
 class EXPORT_MAEPARSER BufferedIndexedBlockMap : public IndexedBlockMapI
 {
   private:
-    std::map<std::string, std::shared_ptr<IndexedBlock>> m_indexed_block;
-    std::map<std::string, std::shared_ptr<IndexedBlockBuffer>> m_indexed_buffer;
+    NameMap<std::shared_ptr<IndexedBlock>> m_indexed_block;
+    NameMap<std::shared_ptr<IndexedBlockBuffer>> m_indexed_buffer;
+    // Blocks materialized from m_indexed_buffer, so that the Arena, which
+    // never reclaims memory, holds at most one of each.
+    mutable NameMap<std::shared_ptr<IndexedBlock>> m_materialized;
+    mutable std::mutex m_materialized_mutex;
 
   public:
+    /**
+     * Indexed blocks are materialized in the provided Arena, if any, once
+     * each, on first request.
+     */
+    explicit BufferedIndexedBlockMap(std::shared_ptr<Arena> arena = nullptr)
+        : m_indexed_block(ArenaAllocator<char>(arena)),
+          m_indexed_buffer(ArenaAllocator<char>(arena)),
+          m_materialized(ArenaAllocator<char>(arena))
+    {
+    }
+
     bool hasIndexedBlock(const std::string& name) const override;
 
     std::shared_ptr<const IndexedBlock>
     getIndexedBlock(const std::string& name) const override;
 
+    bool hasIndexedBlock(InternedName name) const override;
+
+    std::shared_ptr<const IndexedBlock>
+    getIndexedBlock(InternedName name) const override;
+
     std::vector<std::string> getBlockNames() const override
     {
         std::vector<std::string> rval;
         for (const auto& p : m_indexed_buffer) {
-            rval.push_back(p.first);
+            rval.push_back(p.first.str());
         }
 
         return rval;
     }
 
+    /**
+     * Read columns straight from the buffered tokens, without materializing
+     * an IndexedBlock.
+     */
+    bool getIntColumn(InternedName block, InternedName column,
+                      std::vector<int>& values) const override;
+
+    std::shared_ptr<const Coordinates>
+    getCoordinates(InternedName block, CoordinateLayout layout) const override;
+
+    size_t getRowCount(InternedName block) const override;
+
+    std::shared_ptr<const IndexedBlockBuffer>
+    getIndexedBlockBuffer(InternedName block) const override;
+
     /**
      * Add an IndexedBlockBuffer to the map, which can be used to retrieve an
      * IndexedBlock.
@@ -105,34 +280,57 @@ class EXPORT_MAEPARSER BufferedIndexedBlockMap : public IndexedBlockMapI
     void addIndexedBlockBuffer(const std::string& name,
                                std::shared_ptr<IndexedBlockBuffer> block_buffer)
     {
-        m_indexed_buffer[name] = std::move(block_buffer);
+        m_indexed_buffer[NameTable::intern(name)] = std::move(block_buffer);
     }
 };
 
 class EXPORT_MAEPARSER Block
 {
   private:
-    const std::string m_name;
+    const InternedName m_name;
 
-    std::map<std::string, BoolProperty> m_bmap;
-    std::map<std::string, double> m_rmap;
-    std::map<std::string, int> m_imap;
-    std::map<std::string, std::string> m_smap;
-    std::map<std::string, std::shared_ptr<Block>> m_sub_block;
+    PropertyMap<BoolProperty> m_bmap;
+    PropertyMap<double> m_rmap;
+    PropertyMap<int> m_imap;
+    PropertyMap<std::string> m_smap;
+    NameMap<std::shared_ptr<Block>> m_sub_block;
     std::shared_ptr<IndexedBlockMapI> m_indexed_block_map;
+    std::shared_ptr<const StructureView> m_structure_view;
+    std::shared_ptr<const BondAdjacency> m_bond_adjacency;
+    std::shared_ptr<const SpatialGrid> m_spatial_grid;
 
   public:
     // Prevent copying.
     Block(const Block&) = delete;
     Block& operator=(const Block&) = delete;
 
-    Block(std::string name)
-        : m_name(std::move(name)), m_bmap(), m_rmap(), m_imap(), m_smap(),
+    Block(const std::string& name) : Block(NameTable::intern(name)) {}
+
+    /**
+     * Create a block whose property storage is allocated from the provided
+     * Arena, or from the heap if it is null.
+     */
+    explicit Block(InternedName name, std::shared_ptr<Arena> arena = nullptr)
+        : m_name(name), m_bmap(ArenaAllocator<char>(arena)),
+          m_rmap(ArenaAllocator<char>(arena)),
+          m_imap(ArenaAllocator<char>(arena)),
+          m_smap(ArenaAllocator<char>(arena)),
+          m_sub_block(ArenaAllocator<char>(arena)),
           m_indexed_block_map(nullptr)
     {
     }
 
-    const std::string& getName() const { return m_name; }
+    /**
+     * Return the Arena this block's storage is allocated from, or null.
+     */
+    std::shared_ptr<Arena> getArena() const
+    {
+        return m_bmap.get_allocator().arena();
+    }
+
+    const std::string& getName() const { return m_name.str(); }
+
+    InternedName getInternedName() const { return m_name; }
 
     std::string toString() const;
 
@@ -143,6 +341,11 @@ class EXPORT_MAEPARSER Block
         m_indexed_block_map = std::move(indexed_block_map);
     }
 
+    std::shared_ptr<const IndexedBlockMapI> getIndexedBlockMap() const
+    {
+        return m_indexed_block_map;
+    }
+
     bool hasIndexedBlockData() const { return m_indexed_block_map != nullptr; }
     bool hasIndexedBlock(const std::string& name)
     {
@@ -150,12 +353,66 @@ class EXPORT_MAEPARSER Block
                m_indexed_block_map->hasIndexedBlock(name);
     }
 
+    bool hasIndexedBlock(InternedName name) const
+    {
+        return hasIndexedBlockData() &&
+               m_indexed_block_map->hasIndexedBlock(name);
+    }
+
     std::shared_ptr<const IndexedBlock>
     getIndexedBlock(const std::string& name) const;
 
+    std::shared_ptr<const IndexedBlock>
+    getIndexedBlock(InternedName name) const;
+
+    /**
+     * Return the core atom and bond columns of this block as typed arrays.
+     *
+     * If the parser built a view while reading the block (see
+     * MaeParser::setStructureViews()), it is returned; otherwise a new view
+     * is built from the indexed blocks.
+     */
+    std::shared_ptr<const StructureView> getStructureView() const;
+
+    void setStructureView(std::shared_ptr<const StructureView> view)
+    {
+        m_structure_view = std::move(view);
+    }
+
+    /**
+     * Return the bonds of this block's m_bond block as an adjacency index.
+     *
+     * If the parser built the index while reading the block (see
+     * MaeParser::setBondAdjacency()), it is returned; otherwise a new index
+     * is built from the indexed blocks. The parser doesn't build one when
+     * the m_bond columns differ in size or refer to nonexistent atoms, in
+     * which case this throws std::invalid_argument or std::out_of_range.
+     */
+    std::shared_ptr<const BondAdjacency> getBondAdjacency() const;
+
+    void setBondAdjacency(std::shared_ptr<const BondAdjacency> adjacency)
+    {
+        m_bond_adjacency = std::move(adjacency);
+    }
+
+    /**
+     * Return a spatial index over the coordinates of this block's m_atom
+     * block.
+     *
+     * If the parser built the index while reading the block (see
+     * MaeParser::setSpatialGrid()), it is returned; otherwise a new index
+     * with the default cell size is built from the indexed blocks.
+     */
+    std::shared_ptr<const SpatialGrid> getSpatialGrid() const;
+
+    void setSpatialGrid(std::shared_ptr<const SpatialGrid> grid)
+    {
+        m_spatial_grid = std::move(grid);
+    }
+
     void addBlock(std::shared_ptr<Block> b)
     {
-        m_sub_block[b->getName()] = std::move(b);
+        m_sub_block[b->getInternedName()] = std::move(b);
     }
 
     /**
@@ -163,9 +420,7 @@ class EXPORT_MAEPARSER Block
      */
     bool hasBlock(const std::string& name)
     {
-        std::map<std::string, std::shared_ptr<Block>>::const_iterator iter =
-            m_sub_block.find(name);
-        return (iter != m_sub_block.end());
+        return has_property(m_sub_block, name);
     }
 
     /**
@@ -173,13 +428,14 @@ class EXPORT_MAEPARSER Block
      */
     std::shared_ptr<Block> getBlock(const std::string& name) const
     {
-        std::map<std::string, std::shared_ptr<Block>>::const_iterator iter =
-            m_sub_block.find(name);
-        if (iter == m_sub_block.end()) {
-            throw std::out_of_range("Sub-block not found: " + name);
-        } else {
-            return iter->second;
+        const auto key = NameTable::find(name);
+        if (key) {
+            auto iter = m_sub_block.find(key);
+            if (iter != m_sub_block.end()) {
+                return iter->second;
+            }
         }
+        throw std::out_of_range("Sub-block not found: " + name);
     }
 
     /**
@@ -189,7 +445,7 @@ class EXPORT_MAEPARSER Block
     {
         std::vector<std::string> names;
         for (auto& n : m_sub_block) {
-            names.push_back(n.first);
+            names.push_back(n.first.str());
         }
         return names;
     }
@@ -206,7 +462,7 @@ class EXPORT_MAEPARSER Block
 
     bool hasRealProperty(const std::string& name) const
     {
-        return (m_rmap.find(name) != m_rmap.end());
+        return has_property(m_rmap, name);
     }
 
     double getRealProperty(const std::string& name) const
@@ -214,14 +470,29 @@ class EXPORT_MAEPARSER Block
         return get_property<double>(m_rmap, name);
     }
 
+    bool hasRealProperty(InternedName key) const
+    {
+        return has_property(m_rmap, key);
+    }
+
+    double getRealProperty(InternedName key) const
+    {
+        return get_property<double>(m_rmap, key);
+    }
+
     void setRealProperty(const std::string& name, double value)
+    {
+        m_rmap[NameTable::intern(name)] = value;
+    }
+
+    void setRealProperty(InternedName name, double value)
     {
         m_rmap[name] = value;
     }
 
     bool hasIntProperty(const std::string& name) const
     {
-        return (m_imap.find(name) != m_imap.end());
+        return has_property(m_imap, name);
     }
 
     int getIntProperty(const std::string& name) const
@@ -229,14 +500,29 @@ class EXPORT_MAEPARSER Block
         return get_property<int>(m_imap, name);
     }
 
+    bool hasIntProperty(InternedName key) const
+    {
+        return has_property(m_imap, key);
+    }
+
+    int getIntProperty(InternedName key) const
+    {
+        return get_property<int>(m_imap, key);
+    }
+
     void setIntProperty(const std::string& name, int value)
+    {
+        m_imap[NameTable::intern(name)] = value;
+    }
+
+    void setIntProperty(InternedName name, int value)
     {
         m_imap[name] = value;
     }
 
     bool hasBoolProperty(const std::string& name) const
     {
-        return (m_bmap.find(name) != m_bmap.end());
+        return has_property(m_bmap, name);
     }
 
     bool getBoolProperty(const std::string& name) const
@@ -244,14 +530,29 @@ class EXPORT_MAEPARSER Block
         return 1u == get_property<BoolProperty>(m_bmap, name);
     }
 
+    bool hasBoolProperty(InternedName key) const
+    {
+        return has_property(m_bmap, key);
+    }
+
+    bool getBoolProperty(InternedName key) const
+    {
+        return 1u == get_property<BoolProperty>(m_bmap, key);
+    }
+
     void setBoolProperty(const std::string& name, bool value)
+    {
+        m_bmap[NameTable::intern(name)] = static_cast<BoolProperty>(value);
+    }
+
+    void setBoolProperty(InternedName name, bool value)
     {
         m_bmap[name] = static_cast<BoolProperty>(value);
     }
 
     bool hasStringProperty(const std::string& name) const
     {
-        return (m_smap.find(name) != m_smap.end());
+        return has_property(m_smap, name);
     }
 
     const std::string& getStringProperty(const std::string& name) const
@@ -259,151 +560,994 @@ class EXPORT_MAEPARSER Block
         return get_property<std::string>(m_smap, name);
     }
 
+    bool hasStringProperty(InternedName key) const
+    {
+        return has_property(m_smap, key);
+    }
+
+    const std::string& getStringProperty(InternedName key) const
+    {
+        return get_property<std::string>(m_smap, key);
+    }
+
     void setStringProperty(const std::string& name, std::string value)
+    {
+        m_smap[NameTable::intern(name)] = std::move(value);
+    }
+
+    void setStringProperty(InternedName name, std::string value)
     {
         m_smap[name] = std::move(value);
     }
 
-    template <typename T> const std::map<std::string, T>& getProperties() const;
+    /**
+     * Return a copy of the properties of type T, ordered by name.
+     */
+    template <typename T>
+    std::map<InternedName, T> getInternedProperties() const;
+
+    /**
+     * Return a copy of the properties of type T, keyed by std::string as
+     * before names were interned. getInternedProperties() doesn't copy the
+     * names.
+     */
+    template <typename T> std::map<std::string, T> getProperties() const
+    {
+        return string_keyed(getInternedProperties<T>());
+    }
+};
+
+/**
+ * How the values of an IndexedProperty are stored.
+ */
+enum class IndexedEncoding {
+    DENSE,    ///< One T per row.
+    BITS,     ///< One bit per row; BoolProperty only.
+    SPARSE,   ///< One T per defined row, with its row index.
+    INT8,     ///< int values that all fit in 8 bits.
+    INT16,    ///< int values that all fit in 16 bits.
+    FLOAT32,  ///< double values stored in single precision.
+    CONSTANT, ///< A single T shared by every defined row.
+    RUNS,     ///< One T per run of equal values, with the row ending it.
+};
+
+/**
+ * When IndexedProperty::compact() may store real values in single precision.
+ */
+enum class RealPrecision {
+    EXACT,  ///< Only if every value is exactly representable as a float.
+    SINGLE, ///< Always; values are rounded to the nearest float.
 };
 
+/**
+ * Convert a narrow stored value to the property's value type.
+ */
+template <typename T, typename N> inline T widen(N value, std::true_type)
+{
+    return static_cast<T>(value);
+}
+
+template <typename T, typename N> inline T widen(N, std::false_type)
+{
+    return T();
+}
+
+/**
+ * Return whether two values can share storage in a CONSTANT or RUNS
+ * property. Zeros of opposite sign are kept apart so they round trip.
+ */
+template <typename T> inline bool same_value(const T& lhs, const T& rhs)
+{
+    return lhs == rhs;
+}
+
+inline bool same_value(double lhs, double rhs)
+{
+    return lhs == rhs && std::signbit(lhs) == std::signbit(rhs);
+}
+
+/**
+ * Return a reference to a static BoolProperty with the provided value, or
+ * null for other types.
+ */
+template <typename T> inline const T* static_bool_value(bool)
+{
+    return nullptr;
+}
+
+template <>
+inline const BoolProperty* static_bool_value<BoolProperty>(bool value)
+{
+    static const BoolProperty values[] = {0, 1};
+    return &values[value ? 1 : 0];
+}
+
 template <typename T> class IndexedProperty
 {
+  public:
+    using size_type = typename std::vector<T>::size_type;
+
+    /// What the const accessors return. Numeric values are returned by
+    /// value, so that narrow encodings can be read without expanding them.
+    using const_reference =
+        typename std::conditional<std::is_arithmetic<T>::value, T,
+                                  const T&>::type;
+
   private:
-    std::vector<T> m_data;
-    boost::dynamic_bitset<>* m_is_null;
+    // The values of a DENSE property. For other encodings, an expanded copy
+    // of the values that is only built by data().
+    mutable std::vector<T> m_data;
+    // Replaced whenever the property is compacted, so that each compact
+    // encoding is expanded at most once.
+    std::unique_ptr<std::once_flag> m_expand_once{new std::once_flag};
+
+    // One bit per row, set if the value is defined. Empty if every value is
+    // defined.
+    Bitmap m_validity;
+
+    size_type m_size;
+    IndexedEncoding m_encoding{IndexedEncoding::DENSE};
+
+    // Set once the property is stored in more than one IndexedBlock.
+    bool m_shared{false};
+
+    // The undefined values as nullIndices() returns them, built from
+    // m_validity on first use.
+    mutable std::unique_ptr<boost::dynamic_bitset<>> m_null_indices;
+    std::unique_ptr<std::once_flag> m_null_once{new std::once_flag};
+
+    // The values of a BITS property.
+    Bitmap m_bits;
+
+    // The defined values of a SPARSE property, and their sorted row indices.
+    // The value of a CONSTANT property. The value of each run of a RUNS
+    // property, and the row after the end of each run.
+    std::vector<T> m_values;
+    std::vector<uint32_t> m_rows;
+
+    // The values of an INT8, INT16 or FLOAT32 property.
+    std::vector<int8_t> m_int8;
+    std::vector<int16_t> m_int16;
+    std::vector<float> m_float32;
+
+    T value(size_type index) const;
+
+    T narrowValue(size_type index) const;
+
+    const T& reference(size_type index) const;
+
+    T element(size_type index, std::true_type) const { return value(index); }
+
+    const T& element(size_type index, std::false_type) const
+    {
+        return reference(index);
+    }
+
+    const_reference element(size_type index) const
+    {
+        return element(index, std::is_arithmetic<T>());
+    }
+
+    const std::vector<T>& expanded() const;
+
+    void makeDense();
+
+    void checkWritable() const
+    {
+        if (m_shared) {
+            throw std::logic_error("Indexed property is shared between "
+                                   "blocks; see "
+                                   "IndexedBlock::unshareColumns().");
+        }
+    }
+
+    void validityChanged()
+    {
+        m_null_indices.reset();
+        m_null_once.reset(new std::once_flag);
+    }
+
+    bool packBits(std::true_type is_bool);
+
+    bool packBits(std::false_type) { return false; }
+
+    bool makeSparse();
+
+    bool makeConstant();
+
+    bool makeRuns();
+
+    bool narrow(std::true_type is_numeric, RealPrecision precision);
+
+    bool narrow(std::false_type, RealPrecision) { return false; }
 
   public:
     // Prevent copying.
     IndexedProperty(const IndexedProperty<T>&) = delete;
     IndexedProperty& operator=(const IndexedProperty<T>&) = delete;
 
-    using size_type = typename std::vector<T>::size_type;
-
     /**
      * Construct an IndexedProperty from a reference to a vector of data.
      * This swaps out the data of the input vector.
      *
-     * The optional boost::dynamic_bitset is owned by the created object.
+     * The optional boost::dynamic_bitset marks undefined values and is owned
+     * (and deleted) by the created object. It may be longer than the data,
+     * for trailing undefined values.
      */
     explicit IndexedProperty(std::vector<T>& data,
-                                boost::dynamic_bitset<>* is_null = nullptr)
-        : m_data(), m_is_null(is_null)
+                             boost::dynamic_bitset<>* is_null = nullptr)
+        : m_data(), m_size(data.size())
     {
         m_data.swap(data);
+        if (is_null != nullptr) {
+            m_validity = Bitmap(is_null->size(), true);
+            for (auto i = is_null->find_first();
+                 i != boost::dynamic_bitset<>::npos;
+                 i = is_null->find_next(i)) {
+                m_validity.reset(i);
+            }
+            delete is_null;
+        }
     }
 
-    ~IndexedProperty()
+    /**
+     * Construct an IndexedProperty from a reference to a vector of data and a
+     * validity bitmap, which is either empty or has a set bit for each
+     * defined value.
+     */
+    IndexedProperty(std::vector<T>& data, Bitmap validity)
+        : m_data(), m_validity(std::move(validity)), m_size(data.size())
     {
-        if (m_is_null != nullptr) {
-            delete m_is_null;
-        }
+        m_data.swap(data);
+        assert(m_validity.empty() || m_validity.size() >= m_size);
     }
 
     bool operator==(const IndexedProperty<T>& rhs) const;
 
-    size_type size() const { return m_data.size(); }
+    size_type size() const { return m_size; }
+
+    IndexedEncoding encoding() const { return m_encoding; }
+
+    /**
+     * Switch to the most compact encoding available for the values: one bit
+     * per value for BoolProperty values, only the defined values if most are
+     * undefined, or the narrowest type that holds every int or real value.
+     * Columns with a single value, or long runs of repeated values, store
+     * each value only once. Real values are only rounded to single
+     * precision if requested.
+     *
+     * Compact encodings are read in place through get() and a const
+     * property's accessors, which return numeric values by value. Only
+     * data() builds a full-width copy of the values, which it keeps. Only
+     * set() and the non-const operator[] and at() switch the property back
+     * to the DENSE encoding. Like them, compact() throws std::logic_error if
+     * the property is shared.
+     */
+    void compact(RealPrecision precision = RealPrecision::EXACT);
 
     bool hasUndefinedValues() const
     {
-        return (m_is_null != NULL && m_is_null->any());
+        return !m_validity.empty() && !m_validity.all();
+    }
+
+    /**
+     * Return the number of defined values.
+     */
+    size_type countDefined() const
+    {
+        return m_validity.empty() ? m_size : m_validity.count();
     }
 
     bool isDefined(size_type index) const
     {
-        if (m_is_null == nullptr) {
-            // Use of assert matches out-of-bounds behavior for dynamic_bitset.
-            assert(index < m_data.size());
+        if (m_validity.empty()) {
+            // Use of assert matches out-of-bounds behavior for Bitmap.
+            assert(index < m_size);
             return true;
         } else {
-            return !m_is_null->test(index);
+            return m_validity.test(index);
         }
     }
 
+    /**
+     * Return whether the property is stored in more than one IndexedBlock;
+     * see IndexedBlock::shareColumns(). Such a property can't be changed.
+     */
+    bool isShared() const { return m_shared; }
+
+    void markShared() { m_shared = true; }
+
     void undefine(size_type index)
     {
-        if (m_is_null == NULL) {
-            m_is_null = new boost::dynamic_bitset<>(m_data.size());
+        checkWritable();
+        if (m_validity.empty()) {
+            m_validity = Bitmap(m_size, true);
         }
-        m_is_null->set(index);
+        m_validity.reset(index);
+        validityChanged();
     }
 
+    /**
+     * Return a value that can be changed in place. A compact property is
+     * switched back to the DENSE encoding first, which throws
+     * std::logic_error if the property is shared; read such properties
+     * through a const reference or get(). Changing a value of a DENSE
+     * shared property changes it for every block that shares it.
+     */
     inline T& operator[](size_type index)
     {
-        if (m_is_null && m_is_null->test(index)) {
+        if (!isDefined(index)) {
             throw std::runtime_error("Indexed property value undefined.");
         }
+        if (m_encoding != IndexedEncoding::DENSE) {
+            checkWritable();
+            makeDense();
+        }
         return m_data[index];
     }
 
-    inline const T& operator[](size_type index) const
+    /**
+     * Return a value. Reading through a const property never changes how
+     * it is stored.
+     */
+    inline const_reference operator[](size_type index) const
     {
-        if (m_is_null && m_is_null->test(index)) {
+        if (!isDefined(index)) {
             throw std::runtime_error("Indexed property value undefined.");
         }
-        return m_data[index];
+        return element(index);
     }
 
     inline T& at(size_type index) { return operator[](index); }
 
-    inline const T& at(size_type index) const { return operator[](index); }
+    inline const_reference at(size_type index) const
+    {
+        return operator[](index);
+    }
 
-    inline const T& at(size_type index, const T& default_) const
+    inline const_reference at(size_type index, const T& default_) const
     {
-        if (m_is_null && m_is_null->test(index)) {
+        if (!isDefined(index)) {
             return default_;
         }
-        return m_data[index];
+        return element(index);
+    }
+
+    /**
+     * Return a copy of a value, without expanding a compact encoding. Values
+     * stored in a narrow type are widened to T.
+     */
+    T get(size_type index) const
+    {
+        if (!isDefined(index)) {
+            throw std::runtime_error("Indexed property value undefined.");
+        }
+        return value(index);
+    }
+
+    T get(size_type index, const T& default_) const
+    {
+        return isDefined(index) ? value(index) : default_;
     }
 
+    /**
+     * Change a value, switching the property to the DENSE encoding. Throws
+     * std::logic_error if the property is shared.
+     */
     void set(size_type index, const T& value)
     {
+        checkWritable();
+        makeDense();
         m_data[index] = value;
-        if (m_is_null != NULL && m_is_null->test(index)) {
-            m_is_null->reset(index);
+        if (!m_validity.empty() && !m_validity.test(index)) {
+            m_validity.set(index);
+            validityChanged();
         }
     }
 
-    const std::vector<T>& data() const { return m_data; }
-    const boost::dynamic_bitset<>* nullIndices() const { return m_is_null; }
-};
+    /**
+     * Return all values, with unspecified values for undefined rows.
+     */
+    const std::vector<T>& data() const { return expanded(); }
+
+    /**
+     * Return the validity bitmap, with a set bit for each defined value, or
+     * an empty Bitmap if every value is defined.
+     */
+    const Bitmap& validity() const { return m_validity; }
+
+    /**
+     * Return a bitset marking the undefined values, or null if every value
+     * is defined. The bitset is owned by the property and built from
+     * validity() on first use; prefer validity().
+     */
+    const boost::dynamic_bitset<>* nullIndices() const
+    {
+        if (m_validity.empty()) {
+            return nullptr;
+        }
+        std::call_once(*m_null_once, [this]() {
+            m_null_indices.reset(
+                new boost::dynamic_bitset<>(m_validity.size()));
+            for (size_type i = 0; i < m_validity.size(); ++i) {
+                m_null_indices->set(i, !m_validity.test(i));
+            }
+        });
+        return m_null_indices.get();
+    }
+
+    /**
+     * Return a Bitmap with a set bit for each value that is defined and true.
+     * BoolProperty only; combine the results for several properties with
+     * Bitmap::operator&= and Bitmap::operator|=.
+     */
+    Bitmap trueValues() const;
+
+    /**
+     * Return the number of values that are defined and true. BoolProperty
+     * only.
+     */
+    size_type countTrue() const { return trueValues().count(); }
+};
+
+template <>
+EXPORT_MAEPARSER bool IndexedProperty<BoolProperty>::operator==(
+    const IndexedProperty<BoolProperty>& rhs) const;
+
+template <>
+EXPORT_MAEPARSER bool
+IndexedProperty<int>::operator==(const IndexedProperty<int>& rhs) const;
+
+template <>
+EXPORT_MAEPARSER bool
+IndexedProperty<double>::operator==(const IndexedProperty<double>& rhs) const;
+
+template <>
+EXPORT_MAEPARSER bool IndexedProperty<std::string>::operator==(
+    const IndexedProperty<std::string>& rhs) const;
+
+template <typename T> T IndexedProperty<T>::value(size_type index) const
+{
+    switch (m_encoding) {
+    case IndexedEncoding::DENSE:
+        return m_data[index];
+    case IndexedEncoding::INT8:
+    case IndexedEncoding::INT16:
+    case IndexedEncoding::FLOAT32:
+        return narrowValue(index);
+    default:
+        return reference(index);
+    }
+}
+
+template <typename T>
+T IndexedProperty<T>::narrowValue(size_type index) const
+{
+    const std::is_arithmetic<T> is_numeric;
+    switch (m_encoding) {
+    case IndexedEncoding::INT8:
+        return widen<T>(m_int8[index], is_numeric);
+    case IndexedEncoding::INT16:
+        return widen<T>(m_int16[index], is_numeric);
+    case IndexedEncoding::FLOAT32:
+        return widen<T>(m_float32[index], is_numeric);
+    default:
+        return T();
+    }
+}
+
+template <typename T>
+const T& IndexedProperty<T>::reference(size_type index) const
+{
+    switch (m_encoding) {
+    case IndexedEncoding::DENSE:
+        return m_data[index];
+    case IndexedEncoding::BITS: {
+        const T* value = static_bool_value<T>(m_bits.test(index));
+        if (value != nullptr) {
+            return *value;
+        }
+    } break;
+    case IndexedEncoding::SPARSE: {
+        // Only called for defined values, which are always stored.
+        auto row = std::lower_bound(m_rows.begin(), m_rows.end(), index);
+        return m_values[row - m_rows.begin()];
+    }
+    case IndexedEncoding::CONSTANT:
+        return m_values.front();
+    case IndexedEncoding::RUNS: {
+        auto run = std::upper_bound(m_rows.begin(), m_rows.end(), index);
+        return m_values[run - m_rows.begin()];
+    }
+    case IndexedEncoding::INT8:
+    case IndexedEncoding::INT16:
+    case IndexedEncoding::FLOAT32:
+        break;
+    }
+    return expanded()[index];
+}
+
+template <typename T>
+const std::vector<T>& IndexedProperty<T>::expanded() const
+{
+    if (m_encoding == IndexedEncoding::DENSE) {
+        return m_data;
+    }
+    std::call_once(*m_expand_once, [this]() {
+        std::vector<T> values;
+        values.reserve(m_size);
+        switch (m_encoding) {
+        case IndexedEncoding::DENSE:
+            break;
+        case IndexedEncoding::BITS:
+            for (size_type i = 0; i < m_size; ++i) {
+                values.push_back(*static_bool_value<T>(m_bits.test(i)));
+            }
+            break;
+        case IndexedEncoding::SPARSE:
+            values.resize(m_size);
+            for (size_type i = 0; i < m_rows.size(); ++i) {
+                values[m_rows[i]] = m_values[i];
+            }
+            break;
+        case IndexedEncoding::CONSTANT:
+            if (m_validity.empty()) {
+                values.assign(m_size, m_values.front());
+                break;
+            }
+            // Undefined rows hold default values, as they do when parsed.
+            values.resize(m_size);
+            for (size_type i = 0; i < m_size; ++i) {
+                if (m_validity.test(i)) {
+                    values[i] = m_values.front();
+                }
+            }
+            break;
+        case IndexedEncoding::RUNS:
+            for (size_type i = 0; i < m_rows.size(); ++i) {
+                values.resize(m_rows[i], m_values[i]);
+            }
+            break;
+        case IndexedEncoding::INT8:
+        case IndexedEncoding::INT16:
+        case IndexedEncoding::FLOAT32:
+            for (size_type i = 0; i < m_size; ++i) {
+                values.push_back(narrowValue(i));
+            }
+            break;
+        }
+        m_data.swap(values);
+    });
+    return m_data;
+}
+
+template <typename T> void IndexedProperty<T>::makeDense()
+{
+    if (m_encoding == IndexedEncoding::DENSE) {
+        return;
+    }
+    expanded();
+    m_bits = Bitmap();
+    std::vector<T>().swap(m_values);
+    std::vector<uint32_t>().swap(m_rows);
+    std::vector<int8_t>().swap(m_int8);
+    std::vector<int16_t>().swap(m_int16);
+    std::vector<float>().swap(m_float32);
+    m_encoding = IndexedEncoding::DENSE;
+}
+
+template <typename T>
+void IndexedProperty<T>::compact(RealPrecision precision)
+{
+    checkWritable();
+    if (m_encoding != IndexedEncoding::DENSE) {
+        return;
+    }
+    if (makeConstant() || packBits(std::is_same<T, BoolProperty>()) ||
+        makeSparse() || makeRuns() ||
+        narrow(std::is_arithmetic<T>(), precision)) {
+        std::vector<T>().swap(m_data);
+        m_expand_once.reset(new std::once_flag);
+    }
+}
+
+template <typename T> bool IndexedProperty<T>::packBits(std::true_type)
+{
+    m_bits = Bitmap(m_size);
+    for (size_type i = 0; i < m_size; ++i) {
+        if (m_data[i]) {
+            m_bits.set(i);
+        }
+    }
+    m_encoding = IndexedEncoding::BITS;
+    return true;
+}
+
+template <typename T> bool IndexedProperty<T>::makeSparse()
+{
+    const size_type defined = countDefined();
+    // Only worthwhile if it at least halves the storage.
+    if (m_validity.empty() || m_size > UINT32_MAX ||
+        defined * (sizeof(T) + sizeof(uint32_t)) * 2 > m_size * sizeof(T)) {
+        return false;
+    }
+    m_values.reserve(defined);
+    m_rows.reserve(defined);
+    for (size_type i = 0; i < m_size; ++i) {
+        if (m_validity.test(i)) {
+            m_values.push_back(std::move(m_data[i]));
+            m_rows.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    m_encoding = IndexedEncoding::SPARSE;
+    return true;
+}
+
+template <typename T> bool IndexedProperty<T>::makeConstant()
+{
+    size_type first = 0;
+    if (!m_validity.empty()) {
+        while (first < m_size && !m_validity.test(first)) {
+            ++first;
+        }
+    }
+    if (first == m_size) {
+        return false;
+    }
+    const T& constant = m_data[first];
+    for (size_type i = first + 1; i < m_size; ++i) {
+        if (!same_value(m_data[i], constant) && isDefined(i)) {
+            return false;
+        }
+    }
+    m_values.push_back(std::move(m_data[first]));
+    m_encoding = IndexedEncoding::CONSTANT;
+    return true;
+}
+
+template <typename T> bool IndexedProperty<T>::makeRuns()
+{
+    if (m_size > UINT32_MAX) {
+        return false;
+    }
+    // Undefined rows hold default values, which are stored in runs of their
+    // own.
+    size_type runs = 1;
+    for (size_type i = 1; i < m_size; ++i) {
+        if (!same_value(m_data[i], m_data[i - 1])) {
+            ++runs;
+        }
+    }
+    // Only worthwhile if it at least halves the storage.
+    if (runs * (sizeof(T) + sizeof(uint32_t)) * 2 > m_size * sizeof(T)) {
+        return false;
+    }
+    m_values.reserve(runs);
+    m_rows.reserve(runs);
+    for (size_type i = 0; i < m_size; ++i) {
+        if (i + 1 == m_size || !same_value(m_data[i + 1], m_data[i])) {
+            m_values.push_back(std::move(m_data[i]));
+            m_rows.push_back(static_cast<uint32_t>(i + 1));
+        }
+    }
+    m_encoding = IndexedEncoding::RUNS;
+    return true;
+}
+
+template <typename T>
+bool IndexedProperty<T>::narrow(std::true_type, RealPrecision precision)
+{
+    if (m_data.empty()) {
+        return false;
+    }
+    if (std::is_integral<T>::value) {
+        const auto range = std::minmax_element(m_data.begin(), m_data.end());
+        const auto low = *range.first;
+        const auto high = *range.second;
+        if (low >= INT8_MIN && high <= INT8_MAX) {
+            m_int8.assign(m_data.begin(), m_data.end());
+            m_encoding = IndexedEncoding::INT8;
+        } else if (low >= INT16_MIN && high <= INT16_MAX) {
+            m_int16.assign(m_data.begin(), m_data.end());
+            m_encoding = IndexedEncoding::INT16;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    for (const auto& value : m_data) {
+        const bool representable =
+            precision == RealPrecision::SINGLE
+                ? std::abs(value) <= std::numeric_limits<float>::max()
+                : static_cast<T>(static_cast<float>(value)) == value;
+        if (!representable) {
+            return false;
+        }
+    }
+    m_float32.reserve(m_data.size());
+    for (const auto& value : m_data) {
+        m_float32.push_back(static_cast<float>(value));
+    }
+    m_encoding = IndexedEncoding::FLOAT32;
+    return true;
+}
+
+template <typename T> Bitmap IndexedProperty<T>::trueValues() const
+{
+    static_assert(std::is_same<T, BoolProperty>::value,
+                  "trueValues() requires BoolProperty values.");
+    Bitmap values;
+    if (m_encoding == IndexedEncoding::BITS) {
+        values = m_bits;
+    } else {
+        values = Bitmap(m_size);
+        for (size_type i = 0; i < m_size; ++i) {
+            if (value(i)) {
+                values.set(i);
+            }
+        }
+    }
+    if (!m_validity.empty()) {
+        // The validity bitmap may be longer than the values.
+        if (m_validity.size() == m_size) {
+            values &= m_validity;
+        } else {
+            Bitmap validity(m_validity);
+            validity.resize(m_size);
+            values &= validity;
+        }
+    }
+    return values;
+}
 
 using IndexedRealProperty = IndexedProperty<double>;
 using IndexedIntProperty = IndexedProperty<int>;
 using IndexedBoolProperty = IndexedProperty<BoolProperty>;
 using IndexedStringProperty = IndexedProperty<std::string>;
 
+/**
+ * A string column stored as a single contiguous character buffer and an
+ * array of offsets into it, rather than as one std::string per value.
+ *
+ * Values are accessed as boost::string_view objects, which remain valid for
+ * the lifetime of the property. Values are appended in row order while the
+ * column is materialized; only values that contain escaped characters are
+ * rewritten on the way in.
+ *
+ * A column with few distinct values can then be dictionary encoded, after
+ * which each distinct value is stored once and every row holds a 16-bit code
+ * into the dictionary. Codes can be compared and grouped directly.
+ */
+class EXPORT_MAEPARSER IndexedStringViewProperty
+{
+  private:
+    // Entry i occupies [m_offsets[i], m_offsets[i + 1]) of m_chars. Entries
+    // are rows, or dictionary values if the column is dictionary encoded.
+    std::vector<char> m_chars;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint16_t> m_codes;
+    bool m_dictionary_encoded{false};
+    bool m_shared{false};
+
+    // One bit per row, set if the value is defined. Empty if every value is
+    // defined.
+    Bitmap m_validity;
+
+    void checkWritable() const;
+
+    void checkAppendable() const;
+
+    void appendOffset();
+
+    boost::string_view entry(size_t entry) const
+    {
+        return boost::string_view(m_chars.data() + m_offsets[entry],
+                                  m_offsets[entry + 1] - m_offsets[entry]);
+    }
+
+  public:
+    /// The code of undefined values in a dictionary encoded column.
+    static const uint16_t UNDEFINED_CODE = 0xFFFF;
+
+    // Prevent copying.
+    IndexedStringViewProperty(const IndexedStringViewProperty&) = delete;
+    IndexedStringViewProperty&
+    operator=(const IndexedStringViewProperty&) = delete;
+
+    using size_type = size_t;
+
+    IndexedStringViewProperty() : m_offsets(1, 0) {}
+
+    /**
+     * Construct a copy of the values of an IndexedStringProperty.
+     */
+    explicit IndexedStringViewProperty(const IndexedStringProperty& property);
+
+    /**
+     * Reserve space for the provided number of values and total characters.
+     */
+    void reserve(size_type values, size_t chars);
+
+    /**
+     * Append a value verbatim.
+     */
+    void push_back(boost::string_view value);
+
+    /**
+     * Append the contents of a quoted MAE string, dropping the backslashes
+     * that escape quotes and backslashes.
+     */
+    void push_back_escaped(boost::string_view value);
+
+    /**
+     * Append an undefined value.
+     */
+    void push_back_undefined();
+
+    size_type size() const
+    {
+        return m_dictionary_encoded ? m_codes.size() : m_offsets.size() - 1;
+    }
+
+    bool hasUndefinedValues() const
+    {
+        return !m_validity.empty() && !m_validity.all();
+    }
+
+    bool isDefined(size_type index) const
+    {
+        assert(index < size());
+        return m_validity.empty() || m_validity.test(index);
+    }
+
+    boost::string_view operator[](size_type index) const
+    {
+        if (!isDefined(index)) {
+            throw std::runtime_error("Indexed property value undefined.");
+        }
+        return entry(m_dictionary_encoded ? m_codes[index] : index);
+    }
+
+    boost::string_view at(size_type index) const { return operator[](index); }
+
+    boost::string_view at(size_type index, boost::string_view default_) const
+    {
+        return isDefined(index) ? operator[](index) : default_;
+    }
+
+    bool operator==(const IndexedStringViewProperty& rhs) const;
+
+    bool operator!=(const IndexedStringViewProperty& rhs) const
+    {
+        return !(operator==(rhs));
+    }
+
+    /**
+     * Return an IndexedStringProperty holding a copy of the values.
+     */
+    std::shared_ptr<IndexedStringProperty> toStringProperty() const;
+
+    /**
+     * Replace the per-row values with a dictionary of distinct values and a
+     * code per row. Values can no longer be appended afterwards.
+     *
+     * The column is left unchanged, and false is returned, if it has more
+     * distinct values than fit in a code or if encoding would not save memory.
+     */
+    bool dictionaryEncode();
+
+    bool isDictionaryEncoded() const { return m_dictionary_encoded; }
+
+    /**
+     * Return whether the property is stored in more than one IndexedBlock;
+     * see IndexedBlock::shareColumns(). Such a property can't be appended to
+     * or dictionary encoded.
+     */
+    bool isShared() const { return m_shared; }
+
+    void markShared() { m_shared = true; }
+
+    /**
+     * Return the dictionary code of a row, or UNDEFINED_CODE. Rows with equal
+     * values have equal codes. The column must be dictionary encoded.
+     */
+    uint16_t code(size_type index) const
+    {
+        assert(m_dictionary_encoded);
+        return m_codes[index];
+    }
+
+    /**
+     * Return the codes of all rows. Empty unless dictionary encoded.
+     */
+    const std::vector<uint16_t>& codes() const { return m_codes; }
+
+    /**
+     * Return the number of distinct values in the dictionary.
+     */
+    size_type dictionarySize() const
+    {
+        return m_dictionary_encoded ? m_offsets.size() - 1 : 0;
+    }
+
+    /**
+     * Return the dictionary value for a code other than UNDEFINED_CODE.
+     */
+    boost::string_view dictionaryValue(uint16_t code) const
+    {
+        assert(m_dictionary_encoded && code < dictionarySize());
+        return entry(code);
+    }
+
+    /**
+     * Return the validity bitmap, with a set bit for each defined value, or
+     * an empty Bitmap if every value is defined.
+     */
+    const Bitmap& validity() const { return m_validity; }
+};
+
 template <typename T>
 inline std::shared_ptr<T>
-get_indexed_property(const std::map<std::string, std::shared_ptr<T>>& map,
-                     const std::string& name)
+get_indexed_property(const PropertyMap<std::shared_ptr<T>>& map,
+                     InternedName key)
 {
-    auto iter = map.find(name);
+    auto iter = map.find(key);
     if (iter == map.end()) {
         return std::shared_ptr<T>(nullptr);
-    } else {
-        return iter->second;
     }
+    return iter->second;
 }
 
 template <typename T>
-inline void set_indexed_property(std::map<std::string, std::shared_ptr<T>>& map,
+inline std::shared_ptr<T>
+get_indexed_property(const PropertyMap<std::shared_ptr<T>>& map,
+                     const std::string& name)
+{
+    const auto key = NameTable::find(name);
+    if (key) {
+        auto iter = map.find(key);
+        if (iter != map.end()) {
+            return iter->second;
+        }
+    }
+    return std::shared_ptr<T>(nullptr);
+}
+
+/**
+ * Return the Coordinates axis stored in the named column: 0 for ATOM_X_COORD,
+ * 1 for ATOM_Y_COORD, 2 for ATOM_Z_COORD, or -1 for any other column.
+ */
+EXPORT_MAEPARSER int coordinate_axis(InternedName name);
+
+template <typename T>
+inline void set_indexed_property(PropertyMap<std::shared_ptr<T>>& map,
                                  const std::string& name,
                                  std::shared_ptr<T> value)
 
 {
-    map[name] = std::move(value);
+    map[NameTable::intern(name)] = std::move(value);
 }
 
 class EXPORT_MAEPARSER IndexedBlock
 {
   private:
-    const std::string m_name;
+    const InternedName m_name;
+
+    PropertyMap<std::shared_ptr<IndexedBoolProperty>> m_bmap;
+    PropertyMap<std::shared_ptr<IndexedIntProperty>> m_imap;
+    PropertyMap<std::shared_ptr<IndexedRealProperty>> m_rmap;
+    // A string column is stored in one of these. getStringProperty() moves
+    // a column from m_svmap to m_smap the first time it is asked for it.
+    mutable PropertyMap<std::shared_ptr<IndexedStringProperty>> m_smap;
+    mutable PropertyMap<std::shared_ptr<IndexedStringViewProperty>> m_svmap;
 
-    std::map<std::string, std::shared_ptr<IndexedBoolProperty>> m_bmap;
-    std::map<std::string, std::shared_ptr<IndexedIntProperty>> m_imap;
-    std::map<std::string, std::shared_ptr<IndexedRealProperty>> m_rmap;
-    std::map<std::string, std::shared_ptr<IndexedStringProperty>> m_smap;
+    std::shared_ptr<const Coordinates> m_coordinates;
+
+    std::map<InternedName, std::shared_ptr<IndexedStringProperty>>
+    sortedStringProperties() const;
+
+    void realPropertyChanged(InternedName name);
 
   public:
     // Prevent copying.
@@ -413,14 +1557,38 @@ class EXPORT_MAEPARSER IndexedBlock
     /**
      * Create an indexed block.
      */
-    IndexedBlock(std::string name)
-        : m_name(std::move(name)), m_bmap(), m_imap(), m_rmap(), m_smap()
+    IndexedBlock(const std::string& name)
+        : IndexedBlock(NameTable::intern(name))
+    {
+    }
+
+    /**
+     * Create an indexed block whose storage is allocated from the provided
+     * Arena, or from the heap if it is null.
+     */
+    explicit IndexedBlock(InternedName name,
+                          std::shared_ptr<Arena> arena = nullptr)
+        : m_name(name), m_bmap(ArenaAllocator<char>(arena)),
+          m_imap(ArenaAllocator<char>(arena)),
+          m_rmap(ArenaAllocator<char>(arena)),
+          m_smap(ArenaAllocator<char>(arena)),
+          m_svmap(ArenaAllocator<char>(arena))
+    {
+    }
+
+    /**
+     * Return the Arena this block's storage is allocated from, or null.
+     */
+    std::shared_ptr<Arena> getArena() const
     {
+        return m_bmap.get_allocator().arena();
     }
 
     size_t size() const;
 
-    const std::string& getName() const { return m_name; }
+    const std::string& getName() const { return m_name.str(); }
+
+    InternedName getInternedName() const { return m_name; }
 
     std::string toString() const;
 
@@ -435,11 +1603,18 @@ class EXPORT_MAEPARSER IndexedBlock
 
     template <typename T>
     void setProperty(const std::string& name,
+                     std::shared_ptr<IndexedProperty<T>> value)
+    {
+        setProperty<T>(NameTable::intern(name), std::move(value));
+    }
+
+    template <typename T>
+    void setProperty(InternedName name,
                      std::shared_ptr<IndexedProperty<T>> value);
 
     bool hasBoolProperty(const std::string& name) const
     {
-        return (m_bmap.find(name) != m_bmap.end());
+        return has_property(m_bmap, name);
     }
 
     std::shared_ptr<IndexedBoolProperty>
@@ -448,6 +1623,16 @@ class EXPORT_MAEPARSER IndexedBlock
         return get_indexed_property<IndexedBoolProperty>(m_bmap, name);
     }
 
+    bool hasBoolProperty(InternedName key) const
+    {
+        return has_property(m_bmap, key);
+    }
+
+    std::shared_ptr<IndexedBoolProperty> getBoolProperty(InternedName key) const
+    {
+        return get_indexed_property<IndexedBoolProperty>(m_bmap, key);
+    }
+
     void setBoolProperty(const std::string& name,
                          std::shared_ptr<IndexedBoolProperty> value)
     {
@@ -457,7 +1642,7 @@ class EXPORT_MAEPARSER IndexedBlock
 
     bool hasIntProperty(const std::string& name) const
     {
-        return (m_imap.find(name) != m_imap.end());
+        return has_property(m_imap, name);
     }
 
     std::shared_ptr<IndexedIntProperty>
@@ -466,6 +1651,16 @@ class EXPORT_MAEPARSER IndexedBlock
         return get_indexed_property<IndexedIntProperty>(m_imap, name);
     }
 
+    bool hasIntProperty(InternedName key) const
+    {
+        return has_property(m_imap, key);
+    }
+
+    std::shared_ptr<IndexedIntProperty> getIntProperty(InternedName key) const
+    {
+        return get_indexed_property<IndexedIntProperty>(m_imap, key);
+    }
+
     void setIntProperty(const std::string& name,
                         std::shared_ptr<IndexedIntProperty> value)
     {
@@ -475,7 +1670,7 @@ class EXPORT_MAEPARSER IndexedBlock
 
     bool hasRealProperty(const std::string& name) const
     {
-        return (m_rmap.find(name) != m_rmap.end());
+        return has_property(m_rmap, name);
     }
 
     std::shared_ptr<IndexedRealProperty>
@@ -484,92 +1679,213 @@ class EXPORT_MAEPARSER IndexedBlock
         return get_indexed_property<IndexedRealProperty>(m_rmap, name);
     }
 
+    bool hasRealProperty(InternedName key) const
+    {
+        return has_property(m_rmap, key);
+    }
+
+    std::shared_ptr<IndexedRealProperty> getRealProperty(InternedName key) const
+    {
+        return get_indexed_property<IndexedRealProperty>(m_rmap, key);
+    }
+
     void setRealProperty(const std::string& name,
                          std::shared_ptr<IndexedRealProperty> value)
     {
         set_indexed_property<IndexedRealProperty>(m_rmap, name,
                                                   std::move(value));
+        realPropertyChanged(NameTable::intern(name));
     }
 
     bool hasStringProperty(const std::string& name) const
     {
-        return (m_smap.find(name) != m_smap.end());
+        return has_property(m_smap, name) || has_property(m_svmap, name);
     }
 
+    /**
+     * Return the named string property. If the column is stored as an
+     * IndexedStringViewProperty, it is copied into an IndexedStringProperty
+     * that replaces it on the first call. That changes the block, so it
+     * mustn't race with other calls on the same block.
+     */
     std::shared_ptr<IndexedStringProperty>
     getStringProperty(const std::string& name) const
     {
-        return get_indexed_property<IndexedStringProperty>(m_smap, name);
+        const auto key = NameTable::find(name);
+        return key ? getStringProperty(key) : nullptr;
     }
 
+    bool hasStringProperty(InternedName key) const
+    {
+        return has_property(m_smap, key) || has_property(m_svmap, key);
+    }
+
+    std::shared_ptr<IndexedStringProperty>
+    getStringProperty(InternedName key) const;
+
+    /**
+     * Store a string column, replacing any IndexedStringViewProperty of the
+     * same name.
+     */
+    void setStringProperty(InternedName key,
+                           std::shared_ptr<IndexedStringProperty> value);
+
     void setStringProperty(const std::string& name,
                            std::shared_ptr<IndexedStringProperty> value)
     {
-        set_indexed_property<IndexedStringProperty>(m_smap, name,
-                                                    std::move(value));
+        setStringProperty(NameTable::intern(name), std::move(value));
+    }
+
+    /**
+     * Return the named string property as an IndexedStringViewProperty. If
+     * the column is stored as an IndexedStringProperty, a new copy of its
+     * values is returned on each call.
+     */
+    std::shared_ptr<IndexedStringViewProperty>
+    getStringViewProperty(const std::string& name) const
+    {
+        const auto key = NameTable::find(name);
+        return key ? getStringViewProperty(key) : nullptr;
     }
 
+    std::shared_ptr<IndexedStringViewProperty>
+    getStringViewProperty(InternedName key) const;
+
+    /**
+     * Store a string column as an IndexedStringViewProperty, replacing any
+     * string property of the same name.
+     */
+    void
+    setStringViewProperty(InternedName key,
+                          std::shared_ptr<IndexedStringViewProperty> value);
+
+    void
+    setStringViewProperty(const std::string& name,
+                          std::shared_ptr<IndexedStringViewProperty> value)
+    {
+        setStringViewProperty(NameTable::intern(name), std::move(value));
+    }
+
+    /**
+     * Return the ATOM_X_COORD, ATOM_Y_COORD and ATOM_Z_COORD columns as a
+     * single aligned buffer, or null if any of them is missing. Undefined
+     * coordinates are NaN.
+     *
+     * If the parser filled a buffer with the requested layout while reading
+     * the block (see MaeParser::setCoordinateBuffers()), it is returned as
+     * is; otherwise a new buffer is built from the columns. Replacing a
+     * coordinate column discards the parsed buffer, but changing values in
+     * place does not; call setCoordinates(nullptr) after doing so.
+     */
+    std::shared_ptr<const Coordinates>
+    getCoordinates(CoordinateLayout layout = CoordinateLayout::SOA) const;
+
+    /**
+     * Store a buffer holding the current values of the coordinate columns.
+     */
+    void setCoordinates(std::shared_ptr<const Coordinates> coordinates)
+    {
+        m_coordinates = std::move(coordinates);
+    }
+
+    /**
+     * Return a new IndexedBlock, allocated from this block's Arena, that
+     * holds this block's columns. Where 'previous' has a column of the same
+     * name and type with exactly the same values, that column is used
+     * instead, so the two blocks share its storage. Shared columns are
+     * marked as such and can't be changed; call unshareColumns() on a block
+     * to copy them first.
+     */
+    std::shared_ptr<IndexedBlock>
+    shareColumns(const IndexedBlock* previous) const;
+
+    /**
+     * Store the named column of 'other' in this block, so the two blocks
+     * share its storage. Return false if 'other' has no such column.
+     */
+    bool shareColumn(const IndexedBlock& other, InternedName name);
+
+    /**
+     * Replace each column that is shared with another block by a private
+     * copy, which can then be changed.
+     */
+    void unshareColumns();
+
+    /**
+     * Return a copy of the properties of type T, ordered by name.
+     */
     template <typename T>
-    const std::map<std::string, std::shared_ptr<IndexedProperty<T>>>&
-    getProperties() const;
+    std::map<InternedName, std::shared_ptr<IndexedProperty<T>>>
+    getInternedProperties() const;
+
+    /**
+     * Return a copy of the properties of type T, keyed by std::string as
+     * before names were interned. getInternedProperties() doesn't copy the
+     * names.
+     */
+    template <typename T>
+    std::map<std::string, std::shared_ptr<IndexedProperty<T>>>
+    getProperties() const
+    {
+        return string_keyed(getInternedProperties<T>());
+    }
 };
 
 // Template specializations
 
 template <>
-inline const std::map<std::string, BoolProperty>&
-Block::getProperties<BoolProperty>() const
+inline std::map<InternedName, BoolProperty>
+Block::getInternedProperties<BoolProperty>() const
 {
-    return m_bmap;
+    return sorted_properties(m_bmap);
 }
 
 template <>
-inline const std::map<std::string, int>& Block::getProperties<int>() const
+inline std::map<InternedName, int> Block::getInternedProperties<int>() const
 {
-    return m_imap;
+    return sorted_properties(m_imap);
 }
 
 template <>
-inline const std::map<std::string, double>& Block::getProperties<double>() const
+inline std::map<InternedName, double>
+Block::getInternedProperties<double>() const
 {
-    return m_rmap;
+    return sorted_properties(m_rmap);
 }
 
 template <>
-inline const std::map<std::string, std::string>&
-Block::getProperties<std::string>() const
+inline std::map<InternedName, std::string>
+Block::getInternedProperties<std::string>() const
 {
-    return m_smap;
+    return sorted_properties(m_smap);
 }
 
 template <>
-inline const std::map<std::string,
-                      std::shared_ptr<IndexedProperty<BoolProperty>>>&
-IndexedBlock::getProperties() const
+inline std::map<InternedName, std::shared_ptr<IndexedProperty<BoolProperty>>>
+IndexedBlock::getInternedProperties() const
 {
-    return m_bmap;
+    return sorted_properties(m_bmap);
 }
 
 template <>
-inline const std::map<std::string, std::shared_ptr<IndexedProperty<int>>>&
-IndexedBlock::getProperties() const
+inline std::map<InternedName, std::shared_ptr<IndexedProperty<int>>>
+IndexedBlock::getInternedProperties() const
 {
-    return m_imap;
+    return sorted_properties(m_imap);
 }
 
 template <>
-inline const std::map<std::string, std::shared_ptr<IndexedProperty<double>>>&
-IndexedBlock::getProperties() const
+inline std::map<InternedName, std::shared_ptr<IndexedProperty<double>>>
+IndexedBlock::getInternedProperties() const
 {
-    return m_rmap;
+    return sorted_properties(m_rmap);
 }
 
 template <>
-inline const std::map<std::string,
-                      std::shared_ptr<IndexedProperty<std::string>>>&
-IndexedBlock::getProperties() const
+inline std::map<InternedName, std::shared_ptr<IndexedProperty<std::string>>>
+IndexedBlock::getInternedProperties() const
 {
-    return m_smap;
+    return sortedStringProperties();
 }
 
 } // namespace mae
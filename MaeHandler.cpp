@@ -0,0 +1,59 @@
+#include "MaeHandler.hpp"
+
+#include <stdexcept>
+
+#include "MaeParser.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+BoolProperty MaeValue::toBool() const
+{
+    if (m_token == "1") {
+        return true;
+    } else if (m_token == "0") {
+        return false;
+    }
+    throw std::out_of_range("Bogus bool.");
+}
+
+int MaeValue::toInt() const
+{
+    return simple_strtol(m_token.data(), m_token.data() + m_token.size());
+}
+
+double MaeValue::toReal() const
+{
+    return parse_real(m_token.data(), m_token.size());
+}
+
+boost::string_view MaeValue::view() const
+{
+    if (m_token.size() >= 2 && m_token.front() == '"' &&
+        m_token.back() == '"') {
+        return m_token.substr(1, m_token.size() - 2);
+    }
+    return m_token;
+}
+
+std::string MaeValue::toString() const
+{
+    const auto text = view();
+    if (text.size() == m_token.size()) {
+        return std::string(text.data(), text.size());
+    }
+    std::string value;
+    value.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && ++i == text.size()) {
+            break;
+        }
+        value.push_back(text[i]);
+    }
+    return value;
+}
+
+} // namespace mae
+} // namespace schrodinger
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_view.hpp>
+
+#include "MaeBlock.hpp"
+#include "MaeParserConfig.hpp"
+#include "NameTable.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+/**
+ * A value read without building blocks: a view of its token in a parser's
+ * buffer, converted only on request. The view is only valid as long as the
+ * text it refers to: for a value passed to a MaeHandler, only during the
+ * callback; for MaeToken::value(), until the next MaeTokenCursor::next();
+ * and for an IndexedBlockRow value, as long as its IndexedBlockBuffer.
+ */
+class EXPORT_MAEPARSER MaeValue
+{
+  private:
+    boost::string_view m_token;
+
+  public:
+    MaeValue() = default;
+
+    explicit MaeValue(boost::string_view token) : m_token(token) {}
+
+    /**
+     * Return the token as it appears in the file, including any quotes.
+     */
+    boost::string_view token() const { return m_token; }
+
+    /**
+     * Return whether the value is defined, i.e. isn't '<>'.
+     */
+    bool isDefined() const { return m_token != "<>"; }
+
+    /**
+     * Convert the value. Throws std::out_of_range for a bad bool and
+     * std::invalid_argument for a bad real.
+     */
+    BoolProperty toBool() const;
+    int toInt() const;
+    double toReal() const;
+
+    /**
+     * Return a string value without its quotes. Any escaped characters are
+     * left as is.
+     */
+    boost::string_view view() const;
+
+    /**
+     * Return a string value without its quotes and, if it was quoted, with
+     * escapes removed.
+     */
+    std::string toString() const;
+};
+
+/**
+ * Callbacks for an event-driven parse of an MAE file; see
+ * MaeParser::outerBlock(MaeHandler&). Nothing is built but what the
+ * handler builds itself. The default implementations do nothing.
+ *
+ * Events are reported in file order: each block's properties come first,
+ * followed by its nested blocks and indexed blocks, and then the block's
+ * onBlockEnd(). Block names, like values, are views that are only valid
+ * during the callback they are passed to.
+ */
+class EXPORT_MAEPARSER MaeHandler
+{
+  public:
+    virtual ~MaeHandler() = default;
+
+    /**
+     * Called at the start of an outer block. The name is empty for the
+     * unnamed format block.
+     */
+    virtual void onOuterBlockBegin(boost::string_view /*name*/) {}
+
+    /**
+     * Called at the start of a nested block that isn't indexed.
+     */
+    virtual void onBlockBegin(boost::string_view /*name*/) {}
+
+    virtual void onProperty(InternedName /*name*/, const MaeValue& /*value*/)
+    {
+    }
+
+    /**
+     * Called at the start of an indexed block, with its row count and
+     * column names. Return false to skip the block's rows, which are then
+     * only scanned.
+     */
+    virtual bool
+    onIndexedBlockBegin(boost::string_view /*name*/, size_t /*rows*/,
+                        const std::vector<InternedName>& /*columns*/)
+    {
+        return true;
+    }
+
+    /**
+     * Called for each row of an indexed block, with the zero-based row
+     * number and one value per column. The file's row index isn't included.
+     */
+    virtual void onIndexedRow(size_t /*row*/,
+                              const std::vector<MaeValue>& /*values*/)
+    {
+    }
+
+    virtual void onIndexedBlockEnd(boost::string_view /*name*/) {}
+
+    /**
+     * Called at the end of each outer and nested block.
+     */
+    virtual void onBlockEnd(boost::string_view /*name*/) {}
+};
+
+} // namespace mae
+} // namespace schrodinger
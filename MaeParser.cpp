@@ -1,11 +1,25 @@
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 
 #include <boost/spirit/include/qi_numeric.hpp>
 #include <boost/spirit/include/qi_parse_attr.hpp>
 
+#include "BondAdjacency.hpp"
 #include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+#include "MaeHandler.hpp"
 #include "MaeParser.hpp"
+#include "SpatialGrid.hpp"
+#include "StructureView.hpp"
 
 #define WHITESPACE ' ' : case '\n' : case '\r' : case '\t'
 
@@ -17,8 +31,6 @@ namespace schrodinger
 namespace mae
 {
 
-static bool property_key_author_name(Buffer& buffer, char*& save);
-
 static std::string outer_block_name(Buffer& buffer);
 
 void read_exception::format(size_t line_number, size_t column, const char* msg)
@@ -38,21 +50,29 @@ void read_exception::format(size_t line_number, size_t column, const char* msg)
 void comment(Buffer& buffer)
 {
     ++buffer.current; // Step past initial '#'
-    while (buffer.current < buffer.end || buffer.load()) {
+    for (;;) {
         switch (*buffer.current) {
         case '#':
             return;
         case '\n':
             ++buffer.line_number;
+            break;
+        case '\0':
+            if (buffer.current >= buffer.end) {
+                if (!buffer.load()) {
+                    throw read_exception(buffer, "Unterminated comment.");
+                }
+                continue;
+            }
+            break;
         }
         ++buffer.current;
     }
-    throw read_exception(buffer, "Unterminated comment.");
 }
 
 void whitespace(Buffer& buffer)
 {
-    while (buffer.current < buffer.end || buffer.load()) {
+    for (;;) {
         switch (*buffer.current) {
         case '\n':
             ++buffer.line_number;
@@ -63,6 +83,11 @@ void whitespace(Buffer& buffer)
         case '#':
             comment(buffer);
             break;
+        case '\0':
+            if (buffer.current >= buffer.end && buffer.load()) {
+                continue;
+            }
+            return;
         default:
             return;
         }
@@ -110,8 +135,15 @@ template <> EXPORT_MAEPARSER int parse_value<int>(Buffer& buffer)
     int sign = 1;
 
     char* save = buffer.current;
-    while (buffer.current < buffer.end || buffer.load()) {
+    for (;;) {
         switch (*buffer.current) {
+        case '\0':
+            if (buffer.current < buffer.end) {
+                throw read_exception(buffer, "Unexpected character.");
+            } else if (buffer.load()) {
+                continue;
+            }
+            return value * sign;
         case ']':
         case WHITESPACE:
             if (save == buffer.current) {
@@ -141,14 +173,21 @@ template <> EXPORT_MAEPARSER int parse_value<int>(Buffer& buffer)
         }
         ++buffer.current;
     }
-    return value * sign;
 }
 
 template <> EXPORT_MAEPARSER double parse_value<double>(Buffer& buffer)
 {
     char* save = buffer.current;
-    while (buffer.current < buffer.end || buffer.load(save)) {
+    for (;;) {
         switch (*buffer.current) {
+        case '\0':
+            if (buffer.current < buffer.end) {
+                throw read_exception(buffer,
+                                     "Unexpected character in real number.");
+            } else if (buffer.load(save)) {
+                continue;
+            }
+            goto done;
         case '-':
         case '.':
         case '0':
@@ -194,18 +233,24 @@ EXPORT_MAEPARSER std::string parse_value<std::string>(Buffer& buffer)
 {
     char* save = buffer.current;
     if (*buffer.current != '"') {
-        while (buffer.current < buffer.end || buffer.load(save)) {
+        for (;;) {
             switch (*buffer.current) {
+            case '\0':
+                if (buffer.current < buffer.end) {
+                    break;
+                } else if (buffer.load(save)) {
+                    continue;
+                }
+                return std::string(save, buffer.current);
             case WHITESPACE:
                 return std::string(save, buffer.current);
             }
             ++buffer.current;
         }
-        return std::string(save, buffer.current);
     } else {
         save = ++buffer.current;
         std::string rval;
-        while (buffer.current < buffer.end || buffer.load(save)) {
+        for (;;) {
             switch (*buffer.current) {
             case '"':
                 rval = std::string(save, buffer.current++);
@@ -213,11 +258,113 @@ EXPORT_MAEPARSER std::string parse_value<std::string>(Buffer& buffer)
                 return rval;
             case '\\':
                 ++buffer.current;
+                if (buffer.current >= buffer.end && !buffer.load(save)) {
+                    throw read_exception(buffer,
+                                         "Unterminated quoted string at EOF.");
+                }
                 break;
+            case '\0':
+                if (buffer.current < buffer.end) {
+                    break;
+                } else if (buffer.load(save)) {
+                    continue;
+                }
+                throw read_exception(buffer,
+                                     "Unterminated quoted string at EOF.");
+            }
+            ++buffer.current;
+        }
+    }
+}
+
+bool undefined_value(Buffer& buffer)
+{
+    if (*buffer.current != '<') {
+        return false;
+    }
+    char* save = buffer.current;
+    ++buffer.current;
+    if (buffer.current >= buffer.end) {
+        if (!buffer.load(save)) {
+            throw read_exception(buffer, "Unexpected EOF.");
+        }
+    }
+    // TODO: not sure, but I assume that unquoted strings like
+    // <foo> are allowed as values. Ugh. This requires saving the
+    // starting point of '<' in case we need to back up.
+    if (*buffer.current != '>') {
+        // Back up and parse as a normal value.
+        --buffer.current;
+        return false;
+    }
+    ++buffer.current;
+    return true;
+}
+
+/**
+ * Read a string value, which mustn't be at the end of the buffer, into a
+ * string view column.
+ */
+static void parse_string_view(Buffer& buffer,
+                              IndexedStringViewProperty& values)
+{
+    if (undefined_value(buffer)) {
+        values.push_back_undefined();
+        return;
+    }
+
+    char* save = buffer.current;
+    if (*buffer.current != '"') {
+        for (;;) {
+            switch (*buffer.current) {
+            case '\0':
+                if (buffer.current < buffer.end) {
+                    break;
+                } else if (buffer.load(save)) {
+                    continue;
+                }
+                values.push_back(
+                    boost::string_view(save, buffer.current - save));
+                return;
+            case WHITESPACE:
+                values.push_back(
+                    boost::string_view(save, buffer.current - save));
+                return;
+            }
+            ++buffer.current;
+        }
+    }
+
+    save = ++buffer.current;
+    bool escaped = false;
+    for (;;) {
+        switch (*buffer.current) {
+        case '"': {
+            const boost::string_view value(save, buffer.current++ - save);
+            if (escaped) {
+                values.push_back_escaped(value);
+            } else {
+                values.push_back(value);
             }
+            return;
+        }
+        case '\\':
+            escaped = true;
             ++buffer.current;
+            if (buffer.current >= buffer.end && !buffer.load(save)) {
+                throw read_exception(buffer,
+                                     "Unterminated quoted string at EOF.");
+            }
+            break;
+        case '\0':
+            if (buffer.current < buffer.end) {
+                break;
+            } else if (buffer.load(save)) {
+                continue;
+            }
+            throw read_exception(buffer, "Unterminated quoted string at EOF.");
         }
-        throw read_exception(buffer, "Unterminated quoted string at EOF.");
+        ++buffer.current;
     }
 }
 
@@ -264,7 +411,82 @@ std::shared_ptr<Block> MaeParser::outerBlock()
         return nullptr;
     }
     std::string name = outer_block_beginning(m_buffer);
-    return blockBody(name);
+    if (m_arena_allocation) {
+        m_arena = std::make_shared<Arena>();
+    }
+    auto block = blockBody(name);
+    if (block->getName() == CT_BLOCK) {
+        const auto& options = m_indexed_block_options;
+        if (options.ensemble_sharing) {
+            shareEnsembleColumns(*block);
+        }
+        std::shared_ptr<StructureView> view;
+        if (options.structure_views) {
+            view = allocate_shared_in<StructureView>(
+                m_arena, *block, options.coordinate_layout);
+            block->setStructureView(view);
+        }
+        if (options.bond_adjacency) {
+            // Leave the adjacency unset for m_bond blocks without usable
+            // columns, rather than failing to read the block.
+            try {
+                block->setBondAdjacency(
+                    allocate_shared_in<BondAdjacency>(m_arena, *block));
+            } catch (const std::invalid_argument&) {
+            } catch (const std::out_of_range&) {
+            }
+        }
+        if (options.spatial_grid) {
+            // Reuse the coordinates of the view, if there is one.
+            block->setSpatialGrid(
+                view != nullptr
+                    ? allocate_shared_in<SpatialGrid>(
+                          m_arena, view->coordinates(),
+                          options.spatial_grid_cell_size)
+                    : allocate_shared_in<SpatialGrid>(
+                          m_arena, *block, options.spatial_grid_cell_size));
+        }
+    }
+    // The parser must not keep the region alive once the block is returned.
+    m_arena = nullptr;
+    return block;
+}
+
+void MaeParser::shareEnsembleColumns(Block& ct)
+{
+    const auto indexed_blocks = ct.getIndexedBlockMap();
+    if (indexed_blocks == nullptr) {
+        return;
+    }
+    const auto& previous = m_ensemble_previous;
+    auto shared = allocate_shared_in<IndexedBlockMap>(m_arena, m_arena);
+    for (const auto& name : indexed_blocks->getBlockNames()) {
+        const auto key = NameTable::intern(name);
+        const auto previous_block =
+            previous != nullptr && previous->hasIndexedBlock(key)
+                ? previous->getIndexedBlock(key)
+                : nullptr;
+
+        // Skip parsing the columns whose tokens haven't changed.
+        std::shared_ptr<const IndexedBlock> block;
+        const auto tokens = indexed_blocks->getIndexedBlockBuffer(key);
+        const auto previous_tokens =
+            m_ensemble_tokens != nullptr
+                ? m_ensemble_tokens->getIndexedBlockBuffer(key)
+                : nullptr;
+        if (tokens != nullptr && previous_tokens != nullptr &&
+            previous_block != nullptr && tokens->sameLayout(*previous_tokens)) {
+            block = tokens->getIndexedBlock(m_arena, *previous_tokens,
+                                            *previous_block);
+        } else {
+            block = indexed_blocks->getIndexedBlock(key);
+        }
+        shared->addIndexedBlock(name,
+                                block->shareColumns(previous_block.get()));
+    }
+    ct.setIndexedBlockMap(shared);
+    m_ensemble_previous = std::move(shared);
+    m_ensemble_tokens = indexed_blocks;
 }
 
 std::string outer_block_name(Buffer& buffer)
@@ -292,7 +514,7 @@ bad_format:
                                  "must be (f|p)_<author>_<name>.");
 }
 
-std::string MaeParser::blockBeginning(int* indexed)
+InternedName MaeParser::internedBlockBeginning(int* indexed)
 {
     *indexed = -1;
 
@@ -301,7 +523,7 @@ std::string MaeParser::blockBeginning(int* indexed)
         throw read_exception(m_buffer, "Bad format for block name; "
                                        "must be <author>_<name>.");
     }
-    std::string name(save, m_buffer.current - save);
+    const auto name = NameTable::intern(save, m_buffer.current - save);
 
     schrodinger::mae::whitespace(m_buffer);
 
@@ -323,32 +545,33 @@ std::string MaeParser::blockBeginning(int* indexed)
     }
 }
 
-std::shared_ptr<Block> MaeParser::blockBody(const std::string& name)
+std::shared_ptr<Block> MaeParser::blockBody(InternedName name)
 {
-    auto block = std::make_shared<Block>(name);
+    auto block = allocate_shared_in<Block>(m_arena, name, m_arena);
     auto indexed_block_parser =
         std::shared_ptr<IndexedBlockParser>(getIndexedBlockParser());
+    indexed_block_parser->setHeaderCache(m_header_cache);
 
-    std::vector<std::shared_ptr<std::string>> property_names;
+    std::vector<InternedName> property_names;
     schrodinger::mae::whitespace(m_buffer);
     properties(&property_names);
 
-    for (auto& property_name : property_names) {
+    for (const auto& property_name : property_names) {
         schrodinger::mae::whitespace(m_buffer);
-        switch ((*property_name)[0]) {
+        switch (property_name[0]) {
         case 'r':
-            block->setRealProperty(*property_name,
+            block->setRealProperty(property_name,
                                    parse_value<double>(m_buffer));
             break;
         case 's':
-            block->setStringProperty(*property_name,
+            block->setStringProperty(property_name,
                                      parse_value<std::string>(m_buffer));
             break;
         case 'i':
-            block->setIntProperty(*property_name, parse_value<int>(m_buffer));
+            block->setIntProperty(property_name, parse_value<int>(m_buffer));
             break;
         case 'b':
-            block->setBoolProperty(*property_name,
+            block->setBoolProperty(property_name,
                                    1u == parse_value<BoolProperty>(m_buffer));
             break;
         }
@@ -363,12 +586,13 @@ std::shared_ptr<Block> MaeParser::blockBody(const std::string& name)
 
     int indexed = -1;
     for (advance(); *m_buffer.current != '}'; advance()) {
-        std::string subblock_name = blockBeginning(&indexed);
+        const auto subblock_name = internedBlockBeginning(&indexed);
         if (indexed < 0) { // Not an indexed block
             auto sub_block = blockBody(subblock_name);
             block->addBlock(std::move(sub_block));
         } else {
-            indexed_block_parser->parse(subblock_name, indexed, m_buffer);
+            indexed_block_parser->parse(subblock_name.str(), indexed,
+                                        m_buffer);
         }
     }
 
@@ -379,11 +603,200 @@ std::shared_ptr<Block> MaeParser::blockBody(const std::string& name)
     return block;
 }
 
+/**
+ * Parse (and throw away) whitespace and comments, keeping everything from
+ * 'save' on if the buffer is reloaded.
+ */
+static void whitespace(Buffer& buffer, char*& save)
+{
+    for (;;) {
+        switch (*buffer.current) {
+        case '\n':
+            ++buffer.line_number;
+        case '\r':
+        case ' ':
+        case '\t':
+            break;
+        case '#':
+            ++buffer.current;
+            while ((buffer.current < buffer.end || buffer.load(save)) &&
+                   *buffer.current != '#') {
+                if (*buffer.current == '\n') {
+                    ++buffer.line_number;
+                }
+                ++buffer.current;
+            }
+            if (buffer.current >= buffer.end) {
+                throw read_exception(buffer, "Unterminated comment.");
+            }
+            break;
+        case '\0':
+            if (buffer.current >= buffer.end && buffer.load(save)) {
+                continue;
+            }
+            return;
+        default:
+            return;
+        }
+        ++buffer.current;
+    }
+}
+
+void value_token(Buffer& buffer, char*& save)
+{
+    if (buffer.current >= buffer.end && !buffer.load(save)) {
+        throw read_exception(buffer, "Unexpected EOF.");
+    }
+    if (*buffer.current != '"') {
+        for (;;) {
+            switch (*buffer.current) {
+            case '\0':
+                if (buffer.current < buffer.end) {
+                    break;
+                } else if (buffer.load(save)) {
+                    continue;
+                }
+                return;
+            case WHITESPACE:
+                return;
+            }
+            ++buffer.current;
+        }
+    }
+    ++buffer.current;
+    for (;;) {
+        switch (*buffer.current) {
+        case '"':
+            ++buffer.current;
+            return;
+        case '\\':
+            ++buffer.current;
+            if (buffer.current >= buffer.end && !buffer.load(save)) {
+                throw read_exception(buffer,
+                                     "Unterminated quoted string at EOF.");
+            }
+            break;
+        case '\0':
+            if (buffer.current < buffer.end) {
+                break;
+            } else if (buffer.load(save)) {
+                continue;
+            }
+            throw read_exception(buffer, "Unterminated quoted string at EOF.");
+        }
+        ++buffer.current;
+    }
+}
+
+bool MaeParser::outerBlock(MaeHandler& handler)
+{
+    if (!m_buffer.load()) {
+        return false;
+    }
+    const std::string name = outer_block_beginning(m_buffer);
+    handler.onOuterBlockBegin(name);
+    blockBody(name, handler);
+    return true;
+}
+
+void MaeParser::blockBody(boost::string_view name, MaeHandler& handler)
+{
+    // Nested blocks are only read once the properties are, so they can
+    // share the list of names.
+    auto& property_names = m_handler_property_names;
+    property_names.clear();
+    schrodinger::mae::whitespace(m_buffer);
+    properties(&property_names);
+
+    for (const auto& property_name : property_names) {
+        schrodinger::mae::whitespace(m_buffer);
+        char* save = m_buffer.current;
+        value_token(m_buffer, save);
+        handler.onProperty(property_name,
+                           MaeValue(boost::string_view(
+                               save, m_buffer.current - save)));
+    }
+
+    auto advance = [this]() {
+        schrodinger::mae::whitespace(m_buffer);
+        if (!m_buffer.load()) {
+            throw read_exception(m_buffer, "Missing '}' for block.");
+        }
+    };
+
+    int indexed = -1;
+    for (advance(); *m_buffer.current != '}'; advance()) {
+        const auto subblock_name = internedBlockBeginning(&indexed);
+        if (indexed < 0) {
+            handler.onBlockBegin(subblock_name.str());
+            blockBody(subblock_name.str(), handler);
+        } else {
+            indexedBlock(subblock_name, indexed, handler);
+        }
+    }
+    ++m_buffer.current;
+    handler.onBlockEnd(name);
+}
+
+void MaeParser::indexedBlock(InternedName name, size_t rows,
+                             MaeHandler& handler)
+{
+    schrodinger::mae::whitespace(m_buffer);
+    const auto& columns = m_header_cache->read(name, m_buffer);
+    const bool report =
+        handler.onIndexedBlockBegin(name.str(), rows, columns);
+
+    // Each row is kept in the buffer until it has been reported, so token
+    // positions are recorded relative to the start of the row.
+    const size_t col_count = columns.size() + 1;
+    auto& offsets = m_handler_offsets;
+    auto& values = m_handler_values;
+    offsets.resize(2 * col_count);
+    values.resize(columns.size());
+    for (size_t row = 0; row < rows; ++row) {
+        schrodinger::mae::whitespace(m_buffer);
+        char* save = m_buffer.current;
+        for (size_t col = 0; col < col_count; ++col) {
+            if (col > 0) {
+                schrodinger::mae::whitespace(m_buffer, save);
+            }
+            offsets[2 * col] = m_buffer.current - save;
+            value_token(m_buffer, save);
+            offsets[2 * col + 1] = m_buffer.current - save;
+        }
+        if (report) {
+            for (size_t col = 1; col < col_count; ++col) {
+                const size_t begin = offsets[2 * col];
+                values[col - 1] = MaeValue(boost::string_view(
+                    save + begin, offsets[2 * col + 1] - begin));
+            }
+            handler.onIndexedRow(row, values);
+        }
+    }
+
+    schrodinger::mae::whitespace(m_buffer);
+    triple_colon(m_buffer);
+    schrodinger::mae::whitespace(m_buffer);
+    if (!character('}', m_buffer)) {
+        throw read_exception(m_buffer, "Missing '}' for indexed block.");
+    }
+    handler.onIndexedBlockEnd(name.str());
+}
+
 void MaeParser::properties(
     std::vector<std::shared_ptr<std::string>>* property_names)
 {
-    std::shared_ptr<std::string> property_name;
-    while ((property_name = property_key(m_buffer)) != nullptr) {
+    std::vector<InternedName> names;
+    properties(&names);
+    for (const auto& name : names) {
+        property_names->push_back(std::make_shared<std::string>(name.str()));
+    }
+}
+
+void MaeParser::properties(std::vector<InternedName>* property_names)
+{
+    InternedName property_name;
+    while ((property_name = interned_property_key(m_buffer))) {
         property_names->push_back(property_name);
         schrodinger::mae::whitespace(m_buffer);
     }
@@ -406,6 +819,12 @@ std::shared_ptr<std::string> MaeParser::property()
 }
 
 std::shared_ptr<std::string> property_key(Buffer& buffer)
+{
+    const auto name = interned_property_key(buffer);
+    return name ? std::make_shared<std::string>(name.str()) : nullptr;
+}
+
+InternedName interned_property_key(Buffer& buffer)
 {
     if (!buffer.load()) {
         throw read_exception(buffer, "Missing property key.");
@@ -419,7 +838,7 @@ std::shared_ptr<std::string> property_key(Buffer& buffer)
     case 's':
         break;
     case ':':
-        return nullptr;
+        return InternedName();
     default:
         goto bad_format;
     }
@@ -438,13 +857,72 @@ std::shared_ptr<std::string> property_key(Buffer& buffer)
     if (!property_key_author_name(buffer, save)) {
         goto bad_format;
     }
-    return std::make_shared<std::string>(save, buffer.current - save);
+    return NameTable::intern(save, buffer.current - save);
 
 bad_format:
     throw read_exception(buffer, "Bad format for property; "
                                  "must be (b|i|r|s)_<author>_<name>.");
 }
 
+const size_t IndexedHeaderCache::HEADERS_PER_BLOCK;
+
+const std::vector<InternedName>&
+IndexedHeaderCache::read(InternedName block, Buffer& buffer)
+{
+    auto& headers = m_headers[block];
+    const size_t available =
+        buffer.current < buffer.end ? buffer.end - buffer.current : 0;
+    for (const auto& header : headers) {
+        if (header.text.size() <= available &&
+            std::memcmp(buffer.current, header.text.data(),
+                        header.text.size()) == 0) {
+            buffer.current += header.text.size();
+            buffer.line_number += header.newlines;
+            ++m_hits;
+            return header.names;
+        }
+    }
+
+    // Keys can't contain whitespace, so unless there's a comment the header
+    // ends at the first ':::' after whitespace. If that is in the buffer,
+    // nothing is loaded while the header is parsed and it can be kept.
+    char* const start = buffer.current;
+    char* text_end = nullptr;
+    bool after_whitespace = true;
+    for (char* p = start; p + 3 <= buffer.end && *p != '#'; ++p) {
+        if (after_whitespace && p[0] == ':' && p[1] == ':' && p[2] == ':') {
+            text_end = p + 3;
+            break;
+        }
+        switch (*p) {
+        case WHITESPACE:
+            after_whitespace = true;
+            break;
+        default:
+            after_whitespace = false;
+        }
+    }
+
+    m_uncached.clear();
+    InternedName name;
+    while ((name = interned_property_key(buffer))) {
+        m_uncached.push_back(name);
+        whitespace(buffer);
+    }
+    triple_colon(buffer);
+    if (text_end == nullptr || buffer.current != text_end) {
+        return m_uncached;
+    }
+
+    if (headers.size() == HEADERS_PER_BLOCK) {
+        headers.erase(headers.begin());
+    }
+    headers.push_back({std::string(start, text_end),
+                       static_cast<size_t>(std::count(start, text_end, '\n')),
+                       m_uncached});
+    return headers.back().names;
+}
+
 bool property_key_author_name(Buffer& buffer, char*& save)
 {
     while (buffer.current < buffer.end || buffer.load(save)) {
@@ -460,8 +938,15 @@ bool property_key_author_name(Buffer& buffer, char*& save)
     }
 
     char* start = buffer.current;
-    while (buffer.current < buffer.end || buffer.load(save)) {
+    for (;;) {
         switch (*buffer.current) {
+        case '\0':
+            if (buffer.current < buffer.end) {
+                break;
+            } else if (buffer.load(save)) {
+                continue;
+            }
+            return false;
         case WHITESPACE:
         case '{':
         case '[':
@@ -469,7 +954,6 @@ bool property_key_author_name(Buffer& buffer, char*& save)
         }
         ++buffer.current;
     }
-    return false;
 }
 
 void IndexedBlockBuffer::value(Buffer& buffer)
@@ -481,8 +965,18 @@ void IndexedBlockBuffer::value(Buffer& buffer)
     }
 
     if (*buffer.current != '"') {
-        while (buffer.current < buffer.end || buffer.load(save)) {
+        for (;;) {
             switch (*buffer.current) {
+            case '\0':
+                if (buffer.current < buffer.end) {
+                    break;
+                } else if (buffer.load(save)) {
+                    continue;
+                }
+                // If EOF is reached...
+                m_tokens_list.setTokenIndices(save - buffer.begin,
+                                              buffer.current - buffer.begin);
+                return;
             case WHITESPACE:
                 m_tokens_list.setTokenIndices(save - buffer.begin,
                                               buffer.current - buffer.begin);
@@ -490,13 +984,9 @@ void IndexedBlockBuffer::value(Buffer& buffer)
             }
             ++buffer.current;
         }
-        // If EOF is reached...
-        m_tokens_list.setTokenIndices(save - buffer.begin,
-                                      buffer.current - buffer.begin);
-        return;
     } else {
         ++buffer.current;
-        while (buffer.current < buffer.end || buffer.load(save)) {
+        for (;;) {
             switch (*buffer.current) {
             case '"':
                 if (*(buffer.current - 1) == '\\') {
@@ -506,82 +996,452 @@ void IndexedBlockBuffer::value(Buffer& buffer)
                 m_tokens_list.setTokenIndices(save - buffer.begin,
                                               buffer.current - buffer.begin);
                 return;
+            case '\0':
+                if (buffer.current < buffer.end) {
+                    break;
+                } else if (buffer.load(save)) {
+                    continue;
+                }
+                throw read_exception(buffer,
+                                     "Unterminated quoted string at EOF.");
             }
             ++buffer.current;
         }
-        throw read_exception(buffer, "Unterminated quoted string at EOF.");
     }
 }
 
-void DirectIndexedBlockParser::parse(const std::string& name, size_t size,
-                                     Buffer& buffer)
+namespace
 {
-    if (m_indexed_block_map == nullptr) {
-        m_indexed_block_map = std::make_shared<IndexedBlockMap>();
-    }
-    auto indexed_block = std::make_shared<IndexedBlock>(name);
-
-    std::vector<std::string> property_keys;
-
-    whitespace(buffer);
-    std::shared_ptr<std::string> property_name;
-    while ((property_name = property_key(buffer)) != nullptr) {
-        property_keys.push_back(*property_name);
-        whitespace(buffer);
+/**
+ * A column of an indexed block that is parsed straight into its values.
+ */
+template <typename T> class DirectColumn
+{
+  public:
+    InternedName name;
+    std::vector<T> values;
+    Bitmap validity;
+
+    DirectColumn(InternedName name, size_t rows) : name(name)
+    {
+        values.reserve(rows);
     }
-    triple_colon(buffer);
 
-    std::vector<IndexedValueParser*> parsers;
-    parsers.reserve(property_keys.size() + 1);
-    IndexedValueParser* p = new IndexedValueCollector<int>("", size);
-    parsers.push_back(p);
-    for (auto& key : property_keys) {
-        switch (key[0]) {
-        case 'b':
-            p = new IndexedValueCollector<BoolProperty>(key, size);
-            break;
-        case 'i':
-            p = new IndexedValueCollector<int>(key, size);
-            break;
-        case 'r':
-            p = new IndexedValueCollector<double>(key, size);
-            break;
-        case 's':
-            p = new IndexedValueCollector<std::string>(key, size);
-            break;
-        default:
-            throw std::out_of_range("An unexpected error was found.");
+    /**
+     * Read a value, which mustn't be at the end of the buffer.
+     */
+    void parse(Buffer& buffer)
+    {
+        if (undefined_value(buffer)) {
+            if (validity.empty()) {
+                validity = Bitmap(values.capacity(), true);
+            }
+            validity.reset(values.size());
+            values.push_back(T());
+        } else {
+            values.push_back(parse_value<T>(buffer));
         }
-        parsers.push_back(p);
     }
 
-    for (size_t i = 0; i < size; ++i) {
-        for (auto parser : parsers) {
-            whitespace(buffer);
-            parser->parse(buffer);
+    void addToIndexedBlock(IndexedBlock& block,
+                           const IndexedBlockOptions& options)
+    {
+        if (!validity.empty()) {
+            validity.resize(values.size());
         }
+        auto ptr = allocate_shared_in<IndexedProperty<T>>(
+            block.getArena(), values, std::move(validity));
+        options.compact(*ptr);
+        block.setProperty<T>(name, ptr);
     }
-    whitespace(buffer);
-    triple_colon(buffer);
-    whitespace(buffer);
-    if (!character('}', buffer)) {
-        throw read_exception(buffer, "Missing '{' for outer block.");
-    }
-
-    for (auto parser : parsers) {
-        parser->addToIndexedBlock(indexed_block.get());
-        delete parser;
-    }
-    m_indexed_block_map->addIndexedBlock(name, std::move(indexed_block));
-}
+};
 
-std::shared_ptr<IndexedBlockMapI> DirectIndexedBlockParser::getIndexedBlockMap()
+/**
+ * The columns of an indexed block, worked out once from its keys, and their
+ * values. Each value is parsed by a non-virtual call that appends it to its
+ * column's vector.
+ */
+class DirectColumnPlan
+{
+  private:
+    enum class Kind : unsigned char {
+        ROW_INDEX,
+        BOOL,
+        INT,
+        REAL,
+        STRING,
+        STRING_VIEW
+    };
+
+    struct Step {
+        Kind kind;
+        size_t column; ///< The index into the vector of its kind.
+    };
+
+    std::vector<Step> m_steps;
+    std::vector<DirectColumn<BoolProperty>> m_bools;
+    std::vector<DirectColumn<int>> m_ints;
+    std::vector<DirectColumn<double>> m_reals;
+    std::vector<DirectColumn<std::string>> m_strings;
+    std::vector<std::shared_ptr<IndexedStringViewProperty>> m_string_views;
+    std::vector<InternedName> m_string_view_names;
+
+    template <typename T>
+    void addColumn(Kind kind, std::vector<DirectColumn<T>>& columns,
+                   InternedName name, size_t rows)
+    {
+        m_steps.push_back({kind, columns.size()});
+        columns.emplace_back(name, rows);
+    }
+
+  public:
+    DirectColumnPlan(const std::vector<InternedName>& keys, size_t rows,
+                     const IndexedBlockOptions& options)
+    {
+        m_steps.reserve(keys.size() + 1);
+        m_steps.push_back({Kind::ROW_INDEX, 0});
+        for (const auto& key : keys) {
+            switch (key[0]) {
+            case 'b':
+                addColumn(Kind::BOOL, m_bools, key, rows);
+                break;
+            case 'i':
+                addColumn(Kind::INT, m_ints, key, rows);
+                break;
+            case 'r':
+                addColumn(Kind::REAL, m_reals, key, rows);
+                break;
+            case 's':
+                if (options.useStringViews()) {
+                    m_steps.push_back({Kind::STRING_VIEW,
+                                       m_string_views.size()});
+                    m_string_views.push_back(
+                        std::make_shared<IndexedStringViewProperty>());
+                    m_string_views.back()->reserve(rows, 0);
+                    m_string_view_names.push_back(key);
+                } else {
+                    addColumn(Kind::STRING, m_strings, key, rows);
+                }
+                break;
+            default:
+                throw std::out_of_range("An unexpected error was found.");
+            }
+        }
+    }
+
+    void parseRows(size_t rows, Buffer& buffer)
+    {
+        for (size_t i = 0; i < rows; ++i) {
+            for (const auto& step : m_steps) {
+                whitespace(buffer);
+                if (buffer.current >= buffer.end) {
+                    throw read_exception(buffer, "Unexpected EOF.");
+                }
+                switch (step.kind) {
+                case Kind::ROW_INDEX: {
+                    // Like the buffered parser, don't keep the row index.
+                    char* save = buffer.current;
+                    value_token(buffer, save);
+                    break;
+                }
+                case Kind::BOOL:
+                    m_bools[step.column].parse(buffer);
+                    break;
+                case Kind::INT:
+                    m_ints[step.column].parse(buffer);
+                    break;
+                case Kind::REAL:
+                    m_reals[step.column].parse(buffer);
+                    break;
+                case Kind::STRING:
+                    m_strings[step.column].parse(buffer);
+                    break;
+                case Kind::STRING_VIEW:
+                    parse_string_view(buffer, *m_string_views[step.column]);
+                    break;
+                }
+            }
+        }
+    }
+
+    void addToIndexedBlock(IndexedBlock& block,
+                           const IndexedBlockOptions& options)
+    {
+        for (auto& column : m_bools) {
+            column.addToIndexedBlock(block, options);
+        }
+        for (auto& column : m_ints) {
+            column.addToIndexedBlock(block, options);
+        }
+        for (auto& column : m_reals) {
+            column.addToIndexedBlock(block, options);
+        }
+        for (auto& column : m_strings) {
+            column.addToIndexedBlock(block, options);
+        }
+        for (size_t i = 0; i < m_string_views.size(); ++i) {
+            if (options.dictionary_encoding) {
+                m_string_views[i]->dictionaryEncode();
+            }
+            block.setStringViewProperty(m_string_view_names[i],
+                                        std::move(m_string_views[i]));
+        }
+    }
+};
+} // namespace
+
+void DirectIndexedBlockParser::parse(const std::string& name, size_t size,
+                                     Buffer& buffer)
+{
+    if (m_indexed_block_map == nullptr) {
+        m_indexed_block_map =
+            allocate_shared_in<IndexedBlockMap>(m_arena, m_arena);
+    }
+    auto indexed_block = allocate_shared_in<IndexedBlock>(
+        m_arena, NameTable::intern(name), m_arena);
+
+    whitespace(buffer);
+    DirectColumnPlan plan(
+        readHeader(indexed_block->getInternedName(), buffer), size,
+        m_options);
+    plan.parseRows(size, buffer);
+    whitespace(buffer);
+    triple_colon(buffer);
+    whitespace(buffer);
+    if (!character('}', buffer)) {
+        throw read_exception(buffer, "Missing '{' for outer block.");
+    }
+
+    plan.addToIndexedBlock(*indexed_block, m_options);
+    if (m_options.coordinate_buffers) {
+        indexed_block->setCoordinates(
+            indexed_block->getCoordinates(m_options.coordinate_layout));
+    }
+    m_indexed_block_map->addIndexedBlock(name, std::move(indexed_block));
+}
+
+std::shared_ptr<IndexedBlockMapI> DirectIndexedBlockParser::getIndexedBlockMap()
 {
     std::shared_ptr<IndexedBlockMapI> map(m_indexed_block_map);
     m_indexed_block_map = nullptr;
     return map;
 }
 
+namespace
+{
+/// The number of tokens below which an indexed block is always tokenized
+/// and converted on the calling thread; starting threads would take longer.
+const size_t PARALLEL_MIN_TOKENS = 65536;
+
+/**
+ * Call 'task' with each index below 'tasks', each on its own thread, the
+ * first on the calling thread. The first exception thrown by any task is
+ * rethrown once they have all finished.
+ */
+void run_in_parallel(size_t tasks, const std::function<void(size_t)>& task)
+{
+    std::vector<std::exception_ptr> errors(tasks);
+    auto work = [&](size_t i) {
+        try {
+            task(i);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(tasks);
+    for (size_t i = 1; i < tasks; ++i) {
+        workers.emplace_back(work, i);
+    }
+    if (tasks > 0) {
+        work(0);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/**
+ * A range of lines of an indexed block's values, tokenized on its own
+ * thread.
+ */
+struct TokenChunk {
+    const char* begin;
+    const char* end;
+    std::vector<TokenBufferList::TokenIndex> tokens;
+    size_t newlines{0};
+
+    /// Whether the chunk ended outside any quoted string or comment.
+    bool complete{false};
+
+    TokenChunk(const char* begin, const char* end) : begin(begin), end(end)
+    {
+    }
+};
+
+/**
+ * Tokenize a chunk as IndexedBlockBuffer::value() and whitespace() do,
+ * recording token offsets from 'base'. A chunk that ends inside a quoted
+ * string or comment is left incomplete.
+ */
+void tokenize_chunk(TokenChunk& chunk, const char* base)
+{
+    const char* p = chunk.begin;
+    const char* const end = chunk.end;
+    while (p < end) {
+        switch (*p) {
+        case '\n':
+            ++chunk.newlines;
+            ++p;
+            continue;
+        case '\r':
+        case ' ':
+        case '\t':
+            ++p;
+            continue;
+        case '#':
+            for (++p; p < end && *p != '#'; ++p) {
+                chunk.newlines += *p == '\n';
+            }
+            if (p == end) {
+                return;
+            }
+            ++p;
+            continue;
+        }
+
+        const char* const start = p;
+        if (*p == '"') {
+            for (++p; p < end && (*p != '"' || *(p - 1) == '\\'); ++p) {
+                chunk.newlines += *p == '\n';
+            }
+            if (p == end) {
+                return;
+            }
+            ++p;
+        } else {
+            while (p < end && *p != ' ' && *p != '\n' && *p != '\r' &&
+                   *p != '\t') {
+                ++p;
+            }
+        }
+        chunk.tokens.push_back({static_cast<uint32_t>(start - base),
+                                static_cast<uint32_t>(p - start)});
+    }
+    chunk.complete = true;
+}
+} // namespace
+
+bool IndexedBlockBuffer::parseChunks(Buffer& buffer, size_t values,
+                                     size_t threads)
+{
+    // Find the closing ':::'. Everything from 'save' on is kept as the
+    // buffer is reloaded, so the whole body of the block ends up in one
+    // contiguous buffer. Size that buffer from the rows already loaded, so
+    // that the body is usually read with a single reload.
+    char* save = buffer.current;
+    size_t min_size = 0;
+    auto have = [this, &buffer, &save, &min_size](size_t offset) {
+        while (buffer.end - save <= static_cast<std::ptrdiff_t>(offset)) {
+            if (min_size == 0) {
+                const auto lines = std::count(save, buffer.end, '\n');
+                min_size = (buffer.end - save) / (lines + 1) * (m_rows + 2);
+            }
+            buffer.current = buffer.end;
+            if (!buffer.load(save, min_size)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    auto give_up = [&buffer, &save]() {
+        buffer.current = save;
+        return false;
+    };
+
+    // The first ':::' ends the body unless it is inside a quoted string or
+    // comment, which the token count below catches. Stopping there keeps
+    // the scan within this block.
+    size_t body_end = 0;
+    for (size_t pos = 0;;) {
+        if (!have(pos)) {
+            return give_up();
+        }
+        const auto colon = static_cast<const char*>(
+            memchr(save + pos, ':', buffer.end - (save + pos)));
+        if (colon == nullptr) {
+            pos = buffer.end - save;
+            continue;
+        }
+        pos = colon - save;
+        if (!have(pos + 2)) {
+            return give_up();
+        }
+        if (save[pos + 1] == ':' && save[pos + 2] == ':') {
+            if (pos == 0 || (save[pos - 1] != ' ' && save[pos - 1] != '\n' &&
+                             save[pos - 1] != '\r' && save[pos - 1] != '\t')) {
+                return give_up();
+            }
+            body_end = pos;
+            break;
+        }
+        ++pos;
+    }
+    if (static_cast<size_t>(save + body_end - buffer.begin) >
+        std::numeric_limits<uint32_t>::max()) {
+        return give_up();
+    }
+
+    // Split the body at line boundaries.
+    std::vector<TokenChunk> chunks;
+    const char* const end = save + body_end;
+    const char* chunk_begin = save;
+    for (size_t i = 1; i <= threads && chunk_begin < end; ++i) {
+        const char* chunk_end = end;
+        if (i < threads) {
+            const char* target = std::max<const char*>(
+                chunk_begin, save + body_end * i / threads);
+            const auto newline =
+                static_cast<const char*>(memchr(target, '\n', end - target));
+            chunk_end = newline != nullptr ? newline + 1 : end;
+        }
+        chunks.emplace_back(chunk_begin, chunk_end);
+        chunk_begin = chunk_end;
+    }
+
+    const char* const base = buffer.begin;
+    run_in_parallel(chunks.size(),
+                    [&](size_t i) { tokenize_chunk(chunks[i], base); });
+
+    // A quoted string or comment spanning chunks, or a ':::' line inside
+    // one, leaves a chunk incomplete or the token count wrong.
+    size_t tokens = 0;
+    for (const auto& chunk : chunks) {
+        if (!chunk.complete) {
+            return give_up();
+        }
+        tokens += chunk.tokens.size();
+    }
+    if (tokens != values) {
+        return give_up();
+    }
+
+    size_t newlines = 0;
+    for (auto& chunk : chunks) {
+        m_tokens_list.appendTokenIndices(chunk.tokens);
+        newlines += chunk.newlines;
+        chunk.tokens = std::vector<TokenBufferList::TokenIndex>();
+    }
+    buffer.current = save + body_end;
+    buffer.line_number += newlines;
+    return true;
+}
+
 void IndexedBlockBuffer::parse(Buffer& buffer)
 {
     // Modifies buffer to use a loader that stores offsets and data in
@@ -599,6 +1459,12 @@ void IndexedBlockBuffer::parse(Buffer& buffer)
     }
     m_tokens_list.appendBufferData(buffer.data());
 
+    if (m_options.tokenization_threads > 1 && values >= PARALLEL_MIN_TOKENS &&
+        parseChunks(buffer, values, m_options.tokenization_threads)) {
+        whitespace(buffer);
+        return;
+    }
+
     for (std::size_t ix = 0; ix < values; ix++) {
         // TODO: Another boost in performance can be had by avoiding the
         // function call overhead for value and whitespace, but simplying
@@ -609,13 +1475,7 @@ void IndexedBlockBuffer::parse(Buffer& buffer)
     whitespace(buffer);
 }
 
-/**
- * This function is measurably faster than strtol.
- *
- * The main reason for this is probably that it does not deal with alternate
- * bases for the integer.
- */
-static long int simple_strtol(const char* ptr, const char* end)
+long int simple_strtol(const char* ptr, const char* end)
 {
     long int value = 0;
     long int sign = 1;
@@ -648,11 +1508,429 @@ static long int simple_strtol(const char* ptr, const char* end)
     return value * sign;
 }
 
+static bool undefined_token(const char* data, size_t len)
+{
+    return len == 2 && data[0] == '<' && data[1] == '>';
+}
+
+double parse_real(const char* data, size_t len)
+{
+    double value = 0;
+    const char* end = data + len;
+    if (!qi::parse(data, end, qi::double_, value) || data != end) {
+        throw std::invalid_argument("Bad floating point representation.");
+    }
+    return value;
+}
+
+size_t IndexedBlockBuffer::column(InternedName name) const
+{
+    for (size_t i = 0; i < m_property_names.size(); ++i) {
+        if (m_property_names[i] == name) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+bool IndexedBlockBuffer::getIntColumn(InternedName name,
+                                      std::vector<int>& values) const
+{
+    const size_t col = column(name);
+    if (col == 0 || name[0] != 'i') {
+        return false;
+    }
+    const size_t col_count = m_property_names.size() + 1;
+    const size_t value_count = col_count * m_rows;
+    const char* data;
+    size_t len;
+    auto token_buffer = m_tokens_list.begin();
+    values.clear();
+    values.reserve(m_rows);
+    for (size_t ix = col; ix < value_count; ix += col_count) {
+        m_tokens_list.getData(ix, &data, &len, token_buffer);
+        values.push_back(
+            undefined_token(data, len) ? 0 : simple_strtol(data, data + len));
+    }
+    return true;
+}
+
+std::shared_ptr<Coordinates>
+IndexedBlockBuffer::getCoordinates(CoordinateLayout layout,
+                                   const std::shared_ptr<Arena>& arena) const
+{
+    size_t columns[3] = {0, 0, 0};
+    for (size_t i = 0; i < m_property_names.size(); ++i) {
+        const int axis = coordinate_axis(m_property_names[i]);
+        if (axis >= 0) {
+            columns[axis] = i + 1;
+        }
+    }
+    if (columns[0] == 0 || columns[1] == 0 || columns[2] == 0) {
+        return nullptr;
+    }
+
+    auto coordinates =
+        allocate_shared_in<Coordinates>(arena, m_rows, layout, arena);
+    const size_t col_count = m_property_names.size() + 1;
+    const size_t increment = coordinates->increment();
+    const char* data;
+    size_t len;
+    for (int axis = 0; axis < 3; ++axis) {
+        double* values = coordinates->axis(axis);
+        auto token_buffer = m_tokens_list.begin();
+        for (size_t row = 0; row < m_rows; ++row) {
+            m_tokens_list.getData(row * col_count + columns[axis], &data,
+                                  &len, token_buffer);
+            values[row * increment] =
+                undefined_token(data, len)
+                    ? std::numeric_limits<double>::quiet_NaN()
+                    : parse_real(data, len);
+        }
+    }
+    return coordinates;
+}
+
 IndexedBlock* IndexedBlockBuffer::getIndexedBlock()
 {
-    auto* iblock = new IndexedBlock(getName());
+    auto* iblock = new IndexedBlock(m_name);
+    fillIndexedBlock(*iblock);
+    return iblock;
+}
+
+std::shared_ptr<IndexedBlock>
+IndexedBlockBuffer::getIndexedBlock(const std::shared_ptr<Arena>& arena)
+{
+    auto iblock = allocate_shared_in<IndexedBlock>(arena, m_name, arena);
+    fillIndexedBlock(*iblock);
+    return iblock;
+}
+
+bool IndexedBlockBuffer::sameLayout(const IndexedBlockBuffer& other) const
+{
+    return m_rows == other.m_rows && m_property_names == other.m_property_names;
+}
+
+std::vector<bool>
+IndexedBlockBuffer::sameTokens(const IndexedBlockBuffer& other,
+                               std::vector<bool> compare) const
+{
+    // Compare row by row, reading the tokens in the order they are stored.
+    const size_t col_count = m_property_names.size() + 1;
+    const char* data;
+    size_t len;
+    const char* other_data;
+    size_t other_len;
+    auto buffer = m_tokens_list.begin();
+    auto other_buffer = other.m_tokens_list.begin();
+    size_t ix = 0;
+    for (size_t row = 0; row < m_rows; ++row) {
+        for (size_t col = 0; col < col_count; ++col, ++ix) {
+            if (!compare[col]) {
+                continue;
+            }
+            m_tokens_list.getData(ix, &data, &len, buffer);
+            other.m_tokens_list.getData(ix, &other_data, &other_len,
+                                        other_buffer);
+            if (len != other_len || std::memcmp(data, other_data, len) != 0) {
+                compare[col] = false;
+            }
+        }
+    }
+    return compare;
+}
+
+std::shared_ptr<IndexedBlock>
+IndexedBlockBuffer::getIndexedBlock(const std::shared_ptr<Arena>& arena,
+                                    const IndexedBlockBuffer& previous,
+                                    const IndexedBlock& previous_block) const
+{
+    auto iblock = allocate_shared_in<IndexedBlock>(arena, m_name, arena);
+    fillIndexedBlock(*iblock, &previous, &previous_block);
+    return iblock;
+}
+
+namespace
+{
+/// The number of tokens converted per slab of rows when materializing an
+/// IndexedBlockBuffer; their index entries and characters fit in cache.
+const size_t SLAB_TOKENS = 4096;
+
+template <typename T> T convert_token(const char* data, size_t len);
+
+template <> BoolProperty convert_token<BoolProperty>(const char* data, size_t)
+{
+    if (data[0] == '1') {
+        return true;
+    } else if (data[0] == '0') {
+        return false;
+    }
+    throw std::out_of_range("Bogus bool.");
+}
+
+template <> int convert_token<int>(const char* data, size_t len)
+{
+    return simple_strtol(data, data + len);
+}
+
+template <> double convert_token<double>(const char* data, size_t len)
+{
+    return parse_real(data, len);
+}
+
+template <>
+std::string convert_token<std::string>(const char* data, size_t len)
+{
+    if (data[0] != '"') { // Check for quote wrapping
+        return std::string(data, len);
+    }
+    // During parsing we check for full quote wrapping
+    auto value = std::string(data + 1, len - 2);
+    remove_escape_characters(value);
+    return value;
+}
+
+template <typename T> void set_axis_value(double*, const T&) {}
+
+void set_axis_value(double* axis_value, const double& value)
+{
+    if (axis_value != nullptr) {
+        *axis_value = value;
+    }
+}
+
+/**
+ * Collects the values of one column of an IndexedBlockBuffer. The block is
+ * materialized a slab of rows at a time, converting the slab's tokens into
+ * every column while they are in cache rather than striding through the
+ * whole token index once per column.
+ */
+class ColumnFiller
+{
+  private:
+    size_t m_column;
+
+  public:
+    /**
+     * 'column' is the position of the column within each row, counting the
+     * row index.
+     */
+    explicit ColumnFiller(size_t column) : m_column(column) {}
+
+    virtual ~ColumnFiller() = default;
+
+    size_t column() const { return m_column; }
+
+    /**
+     * Add the values of every 'stride'th token from 'ix' up to 'end'.
+     * 'token_buffer' is where to start searching for the first token.
+     */
+    virtual void fill(const TokenBufferList& tokens,
+                      TokenBufferList::const_iterator token_buffer, size_t ix,
+                      size_t end, size_t stride) = 0;
+
+    /**
+     * Build the column's property once every value has been added. This
+     * may run on a worker thread.
+     */
+    virtual void finish() = 0;
+
+    virtual void addToIndexedBlock(IndexedBlock& iblock) = 0;
+};
+
+template <typename T> class ValueColumnFiller : public ColumnFiller
+{
+  private:
+    InternedName m_name;
+    std::vector<T> m_values;
+    Bitmap m_validity;
+    size_t m_rows;
+    const IndexedBlockOptions& m_options;
+    std::shared_ptr<Arena> m_arena;
+    std::shared_ptr<IndexedProperty<T>> m_property;
+
+    /// The coordinate buffer axis the values are also copied to, if any.
+    double* m_axis_values{nullptr};
+    size_t m_increment{0};
+
+  public:
+    ValueColumnFiller(InternedName name, size_t column, size_t rows,
+                      const IndexedBlockOptions& options,
+                      std::shared_ptr<Arena> arena, Coordinates* coordinates)
+        : ColumnFiller(column), m_name(name), m_rows(rows),
+          m_options(options), m_arena(std::move(arena))
+    {
+        m_values.reserve(rows);
+        if (coordinates != nullptr && coordinate_axis(name) >= 0) {
+            m_axis_values = coordinates->axis(coordinate_axis(name));
+            m_increment = coordinates->increment();
+        }
+    }
+
+    void fill(const TokenBufferList& tokens,
+              TokenBufferList::const_iterator token_buffer, size_t ix,
+              size_t end, size_t stride) override
+    {
+        const char* data;
+        size_t len;
+        for (; ix < end; ix += stride) {
+            tokens.getData(ix, &data, &len, token_buffer);
+            double* axis_value =
+                m_axis_values != nullptr
+                    ? m_axis_values + m_values.size() * m_increment
+                    : nullptr;
+            if (undefined_token(data, len)) {
+                if (m_validity.empty()) {
+                    m_validity = Bitmap(m_rows, true);
+                }
+                if (axis_value != nullptr) {
+                    *axis_value = std::numeric_limits<double>::quiet_NaN();
+                }
+                m_validity.reset(m_values.size());
+                m_values.push_back(T());
+            } else {
+                m_values.push_back(convert_token<T>(data, len));
+                set_axis_value(axis_value, m_values.back());
+            }
+        }
+    }
+
+    void finish() override
+    {
+        m_property = allocate_shared_in<IndexedProperty<T>>(
+            m_arena, m_values, std::move(m_validity));
+        m_options.compact(*m_property);
+
+        // Copy values rounded to single precision to the coordinate buffer
+        // too, so that the two agree.
+        if (m_axis_values != nullptr &&
+            m_property->encoding() == IndexedEncoding::FLOAT32) {
+            for (size_t i = 0; i < m_property->size(); ++i) {
+                if (m_property->isDefined(i)) {
+                    set_axis_value(m_axis_values + i * m_increment,
+                                   m_property->get(i));
+                }
+            }
+        }
+    }
+
+    void addToIndexedBlock(IndexedBlock& iblock) override
+    {
+        iblock.setProperty<T>(m_name, std::move(m_property));
+    }
+};
+
+class StringViewColumnFiller : public ColumnFiller
+{
+  private:
+    InternedName m_name;
+    std::shared_ptr<IndexedStringViewProperty> m_values;
+    bool m_dictionary_encoding;
+
+  public:
+    StringViewColumnFiller(InternedName name, size_t column, size_t rows,
+                           size_t chars, const IndexedBlockOptions& options,
+                           const std::shared_ptr<Arena>& arena)
+        : ColumnFiller(column), m_name(name),
+          m_values(allocate_shared_in<IndexedStringViewProperty>(arena)),
+          m_dictionary_encoding(options.dictionary_encoding)
+    {
+        m_values->reserve(rows, chars);
+    }
+
+    void fill(const TokenBufferList& tokens,
+              TokenBufferList::const_iterator token_buffer, size_t ix,
+              size_t end, size_t stride) override
+    {
+        const char* data;
+        size_t len;
+        for (; ix < end; ix += stride) {
+            tokens.getData(ix, &data, &len, token_buffer);
+            if (undefined_token(data, len)) {
+                m_values->push_back_undefined();
+            } else if (data[0] != '"') {
+                m_values->push_back(boost::string_view(data, len));
+            } else {
+                // During parsing we check for full quote wrapping
+                m_values->push_back_escaped(
+                    boost::string_view(data + 1, len - 2));
+            }
+        }
+    }
+
+    void finish() override
+    {
+        if (m_dictionary_encoding) {
+            m_values->dictionaryEncode();
+        }
+    }
+
+    void addToIndexedBlock(IndexedBlock& iblock) override
+    {
+        iblock.setStringViewProperty(m_name, std::move(m_values));
+    }
+};
 
-    std::vector<std::string>::const_iterator iter = m_property_names.begin();
+/**
+ * Convert the tokens of a block's columns into 'fillers' a slab of rows at
+ * a time, and finish their properties.
+ */
+void fill_columns(const TokenBufferList& tokens, size_t rows,
+                  size_t col_count, const std::vector<ColumnFiller*>& fillers)
+{
+    const size_t slab_rows = std::max<size_t>(1, SLAB_TOKENS / col_count);
+    auto token_buffer = tokens.begin();
+    for (size_t row = 0; row < rows && !fillers.empty(); row += slab_rows) {
+        const size_t first = row * col_count;
+        const size_t end = std::min(rows, row + slab_rows) * col_count;
+
+        // Find the buffer of the slab's first token for every column.
+        const char* data;
+        size_t len;
+        tokens.getData(first, &data, &len, token_buffer);
+        for (auto filler : fillers) {
+            filler->fill(tokens, token_buffer, first + filler->column(), end,
+                         col_count);
+        }
+    }
+    for (auto filler : fillers) {
+        filler->finish();
+    }
+}
+
+/**
+ * Convert the columns of a block on up to 'threads' threads, each taking
+ * every 'threads'th column so that column types are spread evenly.
+ */
+void fill_columns(const TokenBufferList& tokens, size_t rows,
+                  size_t col_count,
+                  const std::vector<std::unique_ptr<ColumnFiller>>& fillers,
+                  size_t threads)
+{
+    threads = std::min(threads, fillers.size());
+    if (threads <= 1 || rows * col_count < PARALLEL_MIN_TOKENS) {
+        threads = 1;
+    }
+    std::vector<std::vector<ColumnFiller*>> shares(threads);
+    for (size_t i = 0; i < fillers.size(); ++i) {
+        shares[i % threads].push_back(fillers[i].get());
+    }
+    if (threads == 1) {
+        fill_columns(tokens, rows, col_count, shares[0]);
+        return;
+    }
+
+    run_in_parallel(threads, [&](size_t i) {
+        fill_columns(tokens, rows, col_count, shares[i]);
+    });
+}
+} // namespace
+
+void IndexedBlockBuffer::fillIndexedBlock(
+    IndexedBlock& iblock, const IndexedBlockBuffer* previous,
+    const IndexedBlock* previous_block) const
+{
+    const auto arena = iblock.getArena();
 
     // Indexed blocks have row indexes explicitly mixed in as the first
     // value of each row. This is why a) prop_indx starts at 1, b)
@@ -660,117 +1938,98 @@ IndexedBlock* IndexedBlockBuffer::getIndexedBlock()
     //
     size_t prop_count = m_property_names.size();
     size_t col_count = prop_count + 1;
-    size_t value_count = col_count * m_rows;
-    boost::dynamic_bitset<>* is_null = nullptr;
-    for (int prop_indx = 1; iter != m_property_names.end();
-         ++iter, ++prop_indx) {
-        char type = (*iter)[0];
-        is_null = nullptr;
+
+    // Coordinates are copied into their buffer as they are parsed.
+    std::shared_ptr<Coordinates> coordinates;
+    if (m_options.coordinate_buffers) {
+        int axes = 0;
+        for (const auto& name : m_property_names) {
+            axes += coordinate_axis(name) >= 0;
+        }
+        if (axes == 3) {
+            coordinates = allocate_shared_in<Coordinates>(
+                arena, m_rows, m_options.coordinate_layout, arena);
+        }
+    }
+
+    // Find the columns that are unchanged since the previous block.
+    std::vector<bool> unchanged;
+    if (previous != nullptr) {
+        std::vector<bool> compare(col_count, false);
+        for (size_t i = 0; i < prop_count; ++i) {
+            compare[i + 1] =
+                !m_options.ensembleParsesColumn(m_property_names[i]);
+        }
+        unchanged = sameTokens(*previous, std::move(compare));
+    }
+
+    // String view columns are sized up front; quotes and escapes only make
+    // the stored values shorter than the tokens.
+    std::vector<size_t> chars;
+    if (m_options.useStringViews()) {
+        chars.assign(col_count, 0);
+        auto token_buffer = m_tokens_list.begin();
         const char* data;
         size_t len;
-        switch (type) {
-        case 'b': {
-            std::vector<BoolProperty> bvalues;
-            bvalues.reserve(m_rows);
-            for (size_t ix = prop_indx; ix < value_count; ix += col_count) {
-                getData(ix, &data, &len);
-                if (data[0] == '<' && data[1] == '>') {
-                    if (is_null == nullptr) {
-                        is_null = new boost::dynamic_bitset<>(m_rows);
-                    }
-                    is_null->set(bvalues.size());
-                    bvalues.push_back(false);
-                } else if (data[0] == '1') {
-                    bvalues.push_back(true);
-                } else if (data[0] == '0') {
-                    bvalues.push_back(false);
-                } else {
-                    throw std::out_of_range("Bogus bool.");
-                }
-            }
-            std::shared_ptr<IndexedBoolProperty> ibp(
-                new IndexedBoolProperty(bvalues, is_null));
-            iblock->setBoolProperty(*iter, ibp);
-        } break;
-        case 'i': {
-            std::vector<int> ivalues;
-            ivalues.reserve(m_rows);
-            for (size_t ix = prop_indx; ix < value_count; ix += col_count) {
-                getData(ix, &data, &len);
-                if (data[0] == '<' && data[1] == '>') {
-                    if (is_null == nullptr) {
-                        is_null = new boost::dynamic_bitset<>(m_rows);
-                    }
-                    is_null->set(ivalues.size());
-                    ivalues.push_back(0);
-                } else {
-                    long int value = simple_strtol(data, data + len);
-                    ivalues.push_back(value);
-                }
-            }
-            std::shared_ptr<IndexedIntProperty> iip(
-                new IndexedIntProperty(ivalues, is_null));
-            iblock->setIntProperty(*iter, iip);
-        } break;
-        case 'r': {
-            std::vector<double> dvalues;
-            dvalues.reserve(m_rows);
-            for (size_t ix = prop_indx; ix < value_count; ix += col_count) {
-                getData(ix, &data, &len);
-                if (data[0] == '<' && data[1] == '>') {
-                    if (is_null == nullptr) {
-                        is_null = new boost::dynamic_bitset<>(m_rows);
-                    }
-                    is_null->set(dvalues.size());
-                    dvalues.push_back(0);
-                } else {
-                    double value = 0;
-                    const char* end = data + len;
-                    if (!qi::parse(data, end, qi::double_, value) ||
-                        data != end) {
-                        throw std::invalid_argument("Bad floating point "
-                                                    "representation.");
-                    }
-                    dvalues.push_back(value);
-                }
-            }
-            std::shared_ptr<IndexedRealProperty> irp(
-                new IndexedRealProperty(dvalues, is_null));
-            iblock->setRealProperty(*iter, irp);
-        } break;
-        case 's': {
-            std::vector<std::string> svalues;
-            svalues.reserve(m_rows);
-            for (size_t ix = prop_indx; ix < value_count; ix += col_count) {
-                getData(ix, &data, &len);
-                if (data[0] == '<' && data[1] == '>') {
-                    if (is_null == nullptr) {
-                        is_null = new boost::dynamic_bitset<>(m_rows);
-                    }
-                    is_null->set(svalues.size());
-                    svalues.emplace_back();
-                } else {
-                    if (data[0] != '"') { // Check for quote wrapping
-                        svalues.emplace_back(data, len);
-                    } else { // During parsing we check for full quote wrapping
-                        auto rval = std::string(data + 1, len - 2);
-                        remove_escape_characters(rval);
-                        svalues.emplace_back(rval);
-                    }
-                }
+        for (size_t ix = 0; ix < col_count * m_rows; ++ix) {
+            m_tokens_list.getData(ix, &data, &len, token_buffer);
+            chars[ix % col_count] += len;
+        }
+    }
+
+    std::vector<std::unique_ptr<ColumnFiller>> fillers;
+    for (size_t prop_indx = 1; prop_indx < col_count; ++prop_indx) {
+        const auto name = m_property_names[prop_indx - 1];
+        if (!unchanged.empty() && unchanged[prop_indx] &&
+            iblock.shareColumn(*previous_block, name)) {
+            continue;
+        }
+        ColumnFiller* filler = nullptr;
+        switch (name[0]) {
+        case 'b':
+            filler = new ValueColumnFiller<BoolProperty>(
+                name, prop_indx, m_rows, m_options, arena, nullptr);
+            break;
+        case 'i':
+            filler = new ValueColumnFiller<int>(name, prop_indx, m_rows,
+                                                m_options, arena, nullptr);
+            break;
+        case 'r':
+            filler = new ValueColumnFiller<double>(
+                name, prop_indx, m_rows, m_options, arena, coordinates.get());
+            break;
+        case 's':
+            if (m_options.useStringViews()) {
+                filler = new StringViewColumnFiller(name, prop_indx, m_rows,
+                                                    chars[prop_indx],
+                                                    m_options, arena);
+            } else {
+                filler = new ValueColumnFiller<std::string>(
+                    name, prop_indx, m_rows, m_options, arena, nullptr);
             }
-            std::shared_ptr<IndexedStringProperty> isp(
-                new IndexedStringProperty(svalues, is_null));
-            iblock->setStringProperty(*iter, isp);
-        } break;
+            break;
+        default:
+            continue;
         }
+        fillers.emplace_back(filler);
+    }
+
+    fill_columns(m_tokens_list, m_rows, col_count, fillers,
+                 m_options.materialization_threads);
+    for (const auto& filler : fillers) {
+        filler->addToIndexedBlock(iblock);
+    }
+    if (coordinates != nullptr) {
+        iblock.setCoordinates(std::move(coordinates));
     }
-    return iblock;
 }
 
-BufferedIndexedBlockParser::BufferedIndexedBlockParser()
+BufferedIndexedBlockParser::BufferedIndexedBlockParser(
+    std::shared_ptr<Arena> arena, const IndexedBlockOptions& options)
+    : IndexedBlockParser(std::move(arena), options)
 {
-    m_indexed_block_map = std::make_shared<BufferedIndexedBlockMap>();
+    m_indexed_block_map =
+        allocate_shared_in<BufferedIndexedBlockMap>(m_arena, m_arena);
 }
 
 std::shared_ptr<IndexedBlockMapI>
@@ -784,14 +2043,10 @@ BufferedIndexedBlockParser::getIndexedBlockMap()
 void BufferedIndexedBlockParser::parse(const std::string& name, size_t size,
                                        Buffer& buffer)
 {
-    auto ibb = std::make_shared<IndexedBlockBuffer>(name, size);
+    auto ibb = allocate_shared_in<IndexedBlockBuffer>(
+        m_arena, NameTable::intern(name), size, m_options);
     whitespace(buffer);
-    std::shared_ptr<std::string> property_name;
-    while ((property_name = property_key(buffer)) != nullptr) {
-        ibb->addPropertyName(std::move(*property_name));
-        whitespace(buffer);
-    }
-    triple_colon(buffer);
+    ibb->setPropertyNames(readHeader(ibb->getInternedName(), buffer));
     ibb->parse(buffer);
     triple_colon(buffer);
     whitespace(buffer);
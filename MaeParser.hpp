@@ -8,18 +8,27 @@
 #define NOEXCEPT noexcept
 #endif
 
+#include <algorithm>
 #include <cerrno>
+#include <cstddef>
 #include <cstdio>
+#include <iterator>
 #include <map>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <boost/dynamic_bitset.hpp>
 #include <utility>
 
+#include "Arena.hpp"
 #include "Buffer.hpp"
 #include "MaeBlock.hpp"
+#include "MaeHandler.hpp"
 #include "MaeParserConfig.hpp"
+#include "NameTable.hpp"
 
 #define MAEPARSER_EXCEPTION_BUFFER_SIZE 256
 
@@ -58,14 +67,36 @@ bool character(char c, Buffer& buffer);
 bool character(char c, Buffer& buffer, char*& save);
 
 /**
- * Parse a full (b|i|r|s)_<author>_<name> property key.
+ * Parse a full (b|i|r|s)_<author>_<name> property key and return its entry in
+ * the NameTable. Names that have been seen before are looked up without
+ * allocating.
  *
- * Return NULL if a starting character of ':' is found (the beginning of the
- * ':::' property name terminator).
+ * Return a null InternedName if a starting character of ':' is found (the
+ * beginning of the ':::' property name terminator).
  *
  * Raise a read_exception in any other situation.
  */
-std::shared_ptr<std::string> property_key(Buffer& buffer);
+EXPORT_MAEPARSER InternedName interned_property_key(Buffer& buffer);
+
+/**
+ * Like interned_property_key(), but return a copy of the name, or nullptr
+ * at the ':::' terminator. Kept for existing callers; new code should use
+ * interned_property_key(), which doesn't allocate.
+ */
+EXPORT_MAEPARSER std::shared_ptr<std::string> property_key(Buffer& buffer);
+
+/**
+ * Parse the <author>_<name> part of a property key or block name, keeping
+ * everything from 'save' on if the buffer is reloaded. Return false if it is
+ * badly formed.
+ */
+EXPORT_MAEPARSER bool property_key_author_name(Buffer& buffer, char*& save);
+
+/**
+ * Read the token of a value, quotes included, keeping everything from 'save'
+ * on if the buffer is reloaded.
+ */
+EXPORT_MAEPARSER void value_token(Buffer& buffer, char*& save);
 
 /**
  * Read through the opening '{' of a named or unnamed outer block.
@@ -77,6 +108,24 @@ EXPORT_MAEPARSER std::string outer_block_beginning(Buffer& buffer);
 
 template <typename T> T parse_value(Buffer& buffer);
 
+/**
+ * Convert the token of an int value. This function is measurably faster
+ * than strtol, probably because it does not deal with alternate bases.
+ */
+EXPORT_MAEPARSER long int simple_strtol(const char* ptr, const char* end);
+
+/**
+ * Convert the token of a real value. Throws std::invalid_argument if it
+ * isn't a valid real.
+ */
+EXPORT_MAEPARSER double parse_real(const char* data, size_t len);
+
+/**
+ * Parse the '<>' marker of an undefined indexed value. Return false without
+ * consuming anything if the next value is something else.
+ */
+EXPORT_MAEPARSER bool undefined_value(Buffer& buffer);
+
 class EXPORT_MAEPARSER read_exception : public std::exception
 {
   private:
@@ -110,40 +159,221 @@ class EXPORT_MAEPARSER Parser
     virtual ~Parser() = default;
 };
 
+/**
+ * Options controlling how the columns of indexed blocks are stored.
+ */
+class EXPORT_MAEPARSER IndexedBlockOptions
+{
+  public:
+    /// Store string columns as IndexedStringViewProperty objects.
+    bool string_views{false};
+
+    /// Store string columns as dictionary encoded IndexedStringViewProperty
+    /// objects where that saves memory.
+    bool dictionary_encoding{false};
+
+    bool useStringViews() const { return string_views || dictionary_encoding; }
+
+    /// Store IndexedProperty columns in their most compact encodings. See
+    /// IndexedProperty::compact().
+    bool compact_columns{false};
+
+    /// Round compact real columns to single precision.
+    bool single_precision_reals{false};
+
+    /// Build a StructureView for each f_m_ct block. See
+    /// Block::getStructureView().
+    bool structure_views{false};
+
+    /// Build a BondAdjacency for each f_m_ct block. See
+    /// Block::getBondAdjacency().
+    bool bond_adjacency{false};
+
+    /// Build a SpatialGrid with this cell size for each f_m_ct block. See
+    /// Block::getSpatialGrid().
+    bool spatial_grid{false};
+    double spatial_grid_cell_size{4.0};
+
+    /// Share the columns of each f_m_ct block's indexed blocks that are
+    /// identical to those of the previous f_m_ct block.
+    bool ensemble_sharing{false};
+
+    /// Columns, besides the coordinates, that are always parsed rather than
+    /// compared with the previous f_m_ct block during ensemble sharing.
+    std::vector<InternedName> ensemble_parsed_columns;
+
+    /**
+     * Return whether ensemble sharing always parses the named column.
+     */
+    bool ensembleParsesColumn(InternedName name) const
+    {
+        return coordinate_axis(name) >= 0 ||
+               std::find(ensemble_parsed_columns.begin(),
+                         ensemble_parsed_columns.end(),
+                         name) != ensemble_parsed_columns.end();
+    }
+
+    /// Convert the columns of each indexed block materialized from tokens
+    /// on up to this many threads.
+    size_t materialization_threads{1};
+
+    /// Tokenize the values of each indexed block on up to this many
+    /// threads.
+    size_t tokenization_threads{1};
+
+    /// Fill a Coordinates buffer with this layout for blocks that have
+    /// coordinate columns. See IndexedBlock::getCoordinates().
+    bool coordinate_buffers{false};
+    CoordinateLayout coordinate_layout{CoordinateLayout::SOA};
+
+    RealPrecision realPrecision() const
+    {
+        return single_precision_reals ? RealPrecision::SINGLE
+                                      : RealPrecision::EXACT;
+    }
+
+    /**
+     * Switch a newly parsed property to its most compact encoding, if
+     * compact columns were requested.
+     */
+    template <typename T> void compact(IndexedProperty<T>& property) const
+    {
+        if (compact_columns) {
+            property.compact(realPrecision());
+        }
+    }
+};
+
+/**
+ * The column names of the indexed block headers read so far, by block name.
+ *
+ * Most files repeat the headers of their m_atom and m_bond blocks byte for
+ * byte in every f_m_ct block. A header that matches one seen before is
+ * skipped with a single comparison rather than having each of its keys
+ * validated and interned again.
+ */
+class EXPORT_MAEPARSER IndexedHeaderCache
+{
+  private:
+    struct Header {
+        std::string text; ///< From the first key through the ':::'.
+        size_t newlines;
+        std::vector<InternedName> names;
+    };
+
+    std::unordered_map<InternedName, std::vector<Header>> m_headers;
+    std::vector<InternedName> m_uncached;
+    size_t m_hits{0};
+
+  public:
+    /// The number of headers kept for each block name.
+    static const size_t HEADERS_PER_BLOCK = 4;
+
+    /**
+     * Read the header of the named indexed block, from its first key
+     * through its ':::', and return its column names. The names are valid
+     * until the next call.
+     *
+     * Headers with comments, or that don't fit in the buffer, are always
+     * parsed and aren't cached.
+     */
+    const std::vector<InternedName>& read(InternedName block, Buffer& buffer);
+
+    /**
+     * Return the number of headers that matched a cached one.
+     */
+    size_t hits() const { return m_hits; }
+};
+
 class EXPORT_MAEPARSER IndexedBlockParser
 {
-    std::vector<std::string> m_property_names;
+  protected:
+    std::shared_ptr<Arena> m_arena;
+    IndexedBlockOptions m_options;
+    std::shared_ptr<IndexedHeaderCache> m_header_cache;
+
+    /**
+     * Read an indexed block's column names through the header cache.
+     */
+    const std::vector<InternedName>& readHeader(InternedName block,
+                                                Buffer& buffer)
+    {
+        if (m_header_cache == nullptr) {
+            m_header_cache = std::make_shared<IndexedHeaderCache>();
+        }
+        return m_header_cache->read(block, buffer);
+    }
 
   public:
+    /**
+     * Parsed indexed blocks are allocated from the provided Arena, if any.
+     */
+    explicit IndexedBlockParser(
+        std::shared_ptr<Arena> arena = nullptr,
+        const IndexedBlockOptions& options = IndexedBlockOptions())
+        : m_arena(std::move(arena)), m_options(options)
+    {
+    }
+
     virtual ~IndexedBlockParser() = default;
 
+    /**
+     * Share a header cache with the parsers of other blocks.
+     */
+    void setHeaderCache(std::shared_ptr<IndexedHeaderCache> cache)
+    {
+        m_header_cache = std::move(cache);
+    }
+
     virtual void parse(const std::string& name, size_t size,
                        Buffer& buffer) = 0;
 
     virtual std::shared_ptr<IndexedBlockMapI> getIndexedBlockMap() = 0;
 };
 
+class IndexedBlockRowIterator;
+
 class EXPORT_MAEPARSER IndexedBlockBuffer
 {
+    friend class IndexedBlockRow;
+
   private:
-    std::vector<std::string> m_property_names;
-    std::string m_name;
+    std::vector<InternedName> m_property_names;
+    InternedName m_name;
     TokenBufferList m_tokens_list;
     size_t m_rows;
+    IndexedBlockOptions m_options;
 
   public:
-    IndexedBlockBuffer(std::string name, size_t rows)
-        : m_property_names(), m_name(std::move(name)), m_rows(rows)
+    IndexedBlockBuffer(const std::string& name, size_t rows)
+        : IndexedBlockBuffer(NameTable::intern(name), rows)
+    {
+    }
+
+    IndexedBlockBuffer(
+        InternedName name, size_t rows,
+        const IndexedBlockOptions& options = IndexedBlockOptions())
+        : m_property_names(), m_name(name), m_rows(rows), m_options(options)
     {
     }
 
     virtual ~IndexedBlockBuffer() = default;
 
-    void addPropertyName(std::string&& name)
+    void addPropertyName(const std::string& name)
+    {
+        m_property_names.push_back(NameTable::intern(name));
+    }
+
+    void addPropertyName(InternedName name)
     {
         m_property_names.push_back(name);
     }
 
+    void setPropertyNames(const std::vector<InternedName>& names)
+    {
+        m_property_names = names;
+    }
+
     /**
      * Parse the indexed block values, store them in a linked list of buffers.
      */
@@ -159,20 +389,205 @@ class EXPORT_MAEPARSER IndexedBlockBuffer
         m_tokens_list.getData(ix, data, len);
     }
 
-    std::string getName() const { return m_name; }
+    const std::string& getName() const { return m_name.str(); }
+
+    InternedName getInternedName() const { return m_name; }
 
     size_t size() const { return m_rows; }
 
+    const std::vector<InternedName>& getPropertyNames() const
+    {
+        return m_property_names;
+    }
+
+    /**
+     * Iterate over the rows of the block straight from the tokens, without
+     * materializing any columns. See IndexedBlockRow.
+     */
+    IndexedBlockRowIterator begin() const;
+    IndexedBlockRowIterator end() const;
+
     IndexedBlock* getIndexedBlock();
+
+    /**
+     * Parse a single int column into 'values', with undefined values as
+     * zero, without materializing the block. Return false if there is no
+     * such column.
+     */
+    bool getIntColumn(InternedName name, std::vector<int>& values) const;
+
+    /**
+     * Parse the coordinate columns into a new buffer in the provided Arena
+     * (or on the heap if it is null), without materializing the block.
+     * Return null if any coordinate column is missing.
+     */
+    std::shared_ptr<Coordinates>
+    getCoordinates(CoordinateLayout layout,
+                   const std::shared_ptr<Arena>& arena) const;
+
+    /**
+     * Materialize the IndexedBlock in the provided Arena (or on the heap if
+     * it is null).
+     */
+    std::shared_ptr<IndexedBlock>
+    getIndexedBlock(const std::shared_ptr<Arena>& arena);
+
+    /**
+     * Return whether this buffer has the same columns, in the same order,
+     * and the same number of rows as 'other'.
+     */
+    bool sameLayout(const IndexedBlockBuffer& other) const;
+
+    /**
+     * Materialize the IndexedBlock in the provided Arena, reusing the
+     * columns of a block materialized from a 'previous' buffer with the same
+     * layout. Each column whose tokens are identical to those of 'previous'
+     * is taken from 'previous_block' without being parsed. Coordinate
+     * columns and the ensemble parsed columns of the options are always
+     * parsed.
+     */
+    std::shared_ptr<IndexedBlock>
+    getIndexedBlock(const std::shared_ptr<Arena>& arena,
+                    const IndexedBlockBuffer& previous,
+                    const IndexedBlock& previous_block) const;
+
+  private:
+    /**
+     * Tokenize the 'values' values of the block on up to 'threads' threads,
+     * splitting them into chunks of lines. The values, up to the first
+     * ':::', are read into the buffer first. Return false, with the buffer
+     * back at the first value, if the values can't be split or don't add
+     * up.
+     */
+    bool parseChunks(Buffer& buffer, size_t values, size_t threads);
+
+    /**
+     * Return the position of a column within each row, counting the row
+     * index, or zero if there is no such column.
+     */
+    size_t column(InternedName name) const;
+
+    /**
+     * Return, for each column (counting the row index), whether it holds
+     * the same tokens as the same column of 'other', which must have the
+     * same layout. Only the columns set in 'compare' are compared.
+     */
+    std::vector<bool> sameTokens(const IndexedBlockBuffer& other,
+                                 std::vector<bool> compare) const;
+
+    void fillIndexedBlock(IndexedBlock& iblock,
+                          const IndexedBlockBuffer* previous = nullptr,
+                          const IndexedBlock* previous_block = nullptr) const;
 };
 
+/**
+ * A row of an IndexedBlockBuffer, whose values are read from the buffer's
+ * tokens as they are requested. Values are only converted when the MaeValue
+ * conversions are called. Unlike the values passed to a MaeHandler, they
+ * view the buffer's own copy of the tokens, so they stay valid as long as
+ * the IndexedBlockBuffer does.
+ */
+class EXPORT_MAEPARSER IndexedBlockRow
+{
+    friend class IndexedBlockRowIterator;
+
+  private:
+    const IndexedBlockBuffer* m_buffer;
+    size_t m_row;
+
+    /// The token buffer of the last value read, to start the next search.
+    mutable TokenBufferList::const_iterator m_token_buffer;
+
+  public:
+    IndexedBlockRow(const IndexedBlockBuffer& buffer, size_t row)
+        : m_buffer(&buffer), m_row(row),
+          m_token_buffer(buffer.m_tokens_list.begin())
+    {
+    }
+
+    /**
+     * Return the zero-based index of the row.
+     */
+    size_t index() const { return m_row; }
+
+    /**
+     * Return the number of values in the row; one per property name.
+     */
+    size_t size() const { return m_buffer->m_property_names.size(); }
+
+    /**
+     * Return the value of a column, in the order of the buffer's property
+     * names. The file's row index isn't one of the columns.
+     */
+    MaeValue operator[](size_t column) const
+    {
+        const char* data = nullptr;
+        size_t length = 0;
+        m_buffer->m_tokens_list.getData((size() + 1) * m_row + column + 1,
+                                        &data, &length, m_token_buffer);
+        return MaeValue(boost::string_view(data, length));
+    }
+};
+
+/**
+ * An input iterator over the rows of an IndexedBlockBuffer.
+ */
+class EXPORT_MAEPARSER IndexedBlockRowIterator
+{
+  private:
+    IndexedBlockRow m_row;
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = IndexedBlockRow;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const IndexedBlockRow*;
+    using reference = const IndexedBlockRow&;
+
+    IndexedBlockRowIterator(const IndexedBlockBuffer& buffer, size_t row)
+        : m_row(buffer, row)
+    {
+    }
+
+    reference operator*() const { return m_row; }
+    pointer operator->() const { return &m_row; }
+
+    IndexedBlockRowIterator& operator++()
+    {
+        ++m_row.m_row;
+        return *this;
+    }
+
+    bool operator==(const IndexedBlockRowIterator& other) const
+    {
+        return m_row.m_row == other.m_row.m_row;
+    }
+
+    bool operator!=(const IndexedBlockRowIterator& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+inline IndexedBlockRowIterator IndexedBlockBuffer::begin() const
+{
+    return IndexedBlockRowIterator(*this, 0);
+}
+
+inline IndexedBlockRowIterator IndexedBlockBuffer::end() const
+{
+    return IndexedBlockRowIterator(*this, m_rows);
+}
+
 class EXPORT_MAEPARSER BufferedIndexedBlockParser : public IndexedBlockParser
 {
   private:
     std::shared_ptr<BufferedIndexedBlockMap> m_indexed_block_map;
 
   public:
-    BufferedIndexedBlockParser();
+    explicit BufferedIndexedBlockParser(
+        std::shared_ptr<Arena> arena = nullptr,
+        const IndexedBlockOptions& options = IndexedBlockOptions());
 
     std::shared_ptr<IndexedBlockMapI> getIndexedBlockMap() override;
 
@@ -184,6 +599,13 @@ class EXPORT_MAEPARSER DirectIndexedBlockParser : public IndexedBlockParser
     std::shared_ptr<IndexedBlockMap> m_indexed_block_map;
 
   public:
+    explicit DirectIndexedBlockParser(
+        std::shared_ptr<Arena> arena = nullptr,
+        const IndexedBlockOptions& options = IndexedBlockOptions())
+        : IndexedBlockParser(std::move(arena), options)
+    {
+    }
+
     void parse(const std::string& name, size_t size, Buffer& buffer) override;
 
     std::shared_ptr<IndexedBlockMapI> getIndexedBlockMap() override;
@@ -198,23 +620,27 @@ class EXPORT_MAEPARSER IndexedValueParser : public Parser
 template <typename T> class IndexedValueCollector : public IndexedValueParser
 {
   public:
-    std::string m_name;
+    InternedName m_name;
     std::vector<T> m_values;
-    boost::dynamic_bitset<>* m_is_null;
+    Bitmap m_validity;
+    IndexedBlockOptions m_options;
 
   public:
-    explicit IndexedValueCollector(std::string name, size_t size)
-        : m_name(std::move(name)), m_values(), m_is_null(nullptr)
+    explicit IndexedValueCollector(const std::string& name, size_t size)
+        : IndexedValueCollector(NameTable::intern(name), size)
     {
-        m_values.reserve(size);
-        m_is_null = nullptr;
     }
 
-    ~IndexedValueCollector() override
+    /**
+     * The collected property is stored as 'options' specify when it is added
+     * to a block.
+     */
+    explicit IndexedValueCollector(
+        InternedName name, size_t size,
+        const IndexedBlockOptions& options = IndexedBlockOptions())
+        : m_name(name), m_values(), m_validity(), m_options(options)
     {
-        if (m_is_null) {
-            delete m_is_null;
-        }
+        m_values.reserve(size);
     }
 
     void parse(Buffer& buffer) override
@@ -224,40 +650,27 @@ template <typename T> class IndexedValueCollector : public IndexedValueParser
                 throw read_exception(buffer, "Unexpected EOF.");
             }
         }
-        if (*buffer.current == '<') {
-            char* save = buffer.current;
-            ++buffer.current;
-            if (buffer.current >= buffer.end) {
-                if (!buffer.load(save)) {
-                    throw read_exception(buffer, "Unexpected EOF.");
-                }
-            }
-            // TODO: not sure, but I assume that unquoted strings like
-            // <foo> are allowed as values. Ugh. This requires saving the
-            // starting point of '<' in case we need to back up.
-            if (*buffer.current != '>') {
-                // Back up and parse as a normal value.
-                --buffer.current;
-            } else {
-                ++buffer.current;
-                if (m_is_null == nullptr) {
-                    m_is_null =
-                        new boost::dynamic_bitset<>(m_values.capacity());
-                }
-                m_is_null->set(m_values.size());
-                m_values.push_back(T());
-                return;
+        if (undefined_value(buffer)) {
+            if (m_validity.empty()) {
+                m_validity = Bitmap(m_values.capacity(), true);
             }
+            m_validity.reset(m_values.size());
+            m_values.push_back(T());
+            return;
         }
         m_values.push_back(parse_value<T>(buffer));
     }
 
     void addToIndexedBlock(IndexedBlock* block) override
     {
-        auto ptr = std::shared_ptr<IndexedProperty<T>>(
-            new IndexedProperty<T>(m_values, m_is_null));
+        if (!m_validity.empty()) {
+            m_validity.resize(m_values.size());
+        }
+        auto ptr = allocate_shared_in<IndexedProperty<T>>(
+            block->getArena(), m_values, std::move(m_validity));
+        m_options.compact(*ptr);
         block->setProperty<T>(m_name, ptr);
-        m_is_null = nullptr;
+        m_validity = Bitmap();
     }
 };
 
@@ -266,10 +679,37 @@ class EXPORT_MAEPARSER MaeParser
   protected:
     Buffer m_buffer;
     std::shared_ptr<std::istream> m_stream;
+    bool m_arena_allocation{false};
+    IndexedBlockOptions m_indexed_block_options;
+
+    /// The Arena for the outer block currently being parsed, if any.
+    std::shared_ptr<Arena> m_arena;
+
+    /// The indexed blocks of the last f_m_ct block, and the tokens they
+    /// were parsed from, for ensemble sharing.
+    std::shared_ptr<const IndexedBlockMap> m_ensemble_previous;
+    std::shared_ptr<const IndexedBlockMapI> m_ensemble_tokens;
+
+    /// The headers of the indexed blocks read so far.
+    std::shared_ptr<IndexedHeaderCache> m_header_cache{
+        std::make_shared<IndexedHeaderCache>()};
+
+    /// Scratch space for outerBlock(MaeHandler&), reused from block to
+    /// block.
+    std::vector<InternedName> m_handler_property_names;
+    std::vector<size_t> m_handler_offsets;
+    std::vector<MaeValue> m_handler_values;
+
+    void shareEnsembleColumns(Block& ct);
+
+    void blockBody(boost::string_view name, MaeHandler& handler);
+
+    void indexedBlock(InternedName name, size_t rows, MaeHandler& handler);
 
     virtual IndexedBlockParser* getIndexedBlockParser()
     {
-        return new BufferedIndexedBlockParser();
+        return new BufferedIndexedBlockParser(m_arena,
+                                              m_indexed_block_options);
     }
 
   public:
@@ -300,7 +740,180 @@ class EXPORT_MAEPARSER MaeParser
     // TODO: finish big three (four)
     virtual ~MaeParser() = default;
 
-    std::shared_ptr<Block> blockBody(const std::string& name);
+    /**
+     * If enabled, everything belonging to each outer block (sub-blocks,
+     * property maps, indexed blocks and their property objects) is allocated
+     * from a single Arena, which is released in one shot when the last of
+     * those objects is destroyed. Column value vectors are still allocated
+     * individually.
+     */
+    void setArenaAllocation(bool arena_allocation)
+    {
+        m_arena_allocation = arena_allocation;
+    }
+
+    /**
+     * If enabled, string columns of indexed blocks are stored as
+     * IndexedStringViewProperty objects: one contiguous character buffer per
+     * column rather than one std::string per value.
+     */
+    void setStringViews(bool string_views)
+    {
+        m_indexed_block_options.string_views = string_views;
+    }
+
+    /**
+     * If enabled, string columns of indexed blocks are stored as
+     * IndexedStringViewProperty objects, dictionary encoded wherever that
+     * saves memory. This suits columns such as residue, chain and atom names
+     * that have few distinct values.
+     */
+    void setDictionaryEncoding(bool dictionary_encoding)
+    {
+        m_indexed_block_options.dictionary_encoding = dictionary_encoding;
+    }
+
+    /**
+     * If enabled, the IndexedProperty columns of indexed blocks are stored in
+     * their most compact encodings; see IndexedProperty::compact().
+     * Compact columns should be read through const references or get() to
+     * keep them compact.
+     */
+    void setCompactColumns(bool compact_columns)
+    {
+        m_indexed_block_options.compact_columns = compact_columns;
+    }
+
+    /**
+     * If enabled along with compact columns, real columns are stored in
+     * single precision, halving their size at the cost of rounding each
+     * value to about seven significant digits. Without this, real columns
+     * are only stored in single precision when that is exact.
+     */
+    void setSinglePrecisionReals(bool single_precision_reals)
+    {
+        m_indexed_block_options.single_precision_reals =
+            single_precision_reals;
+    }
+
+    /**
+     * If enabled, the coordinate columns of indexed blocks are also copied
+     * into an aligned Coordinates buffer with the provided layout as they
+     * are parsed, so IndexedBlock::getCoordinates() returns it without
+     * another pass over the columns.
+     */
+    void setCoordinateBuffers(bool coordinate_buffers,
+                              CoordinateLayout layout = CoordinateLayout::SOA)
+    {
+        m_indexed_block_options.coordinate_buffers = coordinate_buffers;
+        m_indexed_block_options.coordinate_layout = layout;
+    }
+
+    /**
+     * If enabled, a StructureView of the core atom and bond columns is built
+     * for each f_m_ct block as it is read; see Block::getStructureView().
+     * With the buffered parser, the columns of the view are parsed straight
+     * from the tokens, and generic IndexedBlocks are only materialized if
+     * they are requested.
+     */
+    void setStructureViews(bool structure_views)
+    {
+        m_indexed_block_options.structure_views = structure_views;
+    }
+
+    /**
+     * If enabled, a BondAdjacency index of the m_bond block is built for
+     * each f_m_ct block as it is read; see Block::getBondAdjacency(). With
+     * the buffered parser, only the bond columns are parsed to build it.
+     */
+    void setBondAdjacency(bool bond_adjacency)
+    {
+        m_indexed_block_options.bond_adjacency = bond_adjacency;
+    }
+
+    /**
+     * If enabled, a SpatialGrid over the atom coordinates is built for each
+     * f_m_ct block as it is read; see Block::getSpatialGrid(). A cell size
+     * close to the typical query radius works best.
+     */
+    void setSpatialGrid(bool spatial_grid, double cell_size = 4.0)
+    {
+        m_indexed_block_options.spatial_grid = spatial_grid;
+        m_indexed_block_options.spatial_grid_cell_size = cell_size;
+    }
+
+    /**
+     * If enabled, consecutive f_m_ct blocks share the indexed block columns
+     * they have in common, as in conformer and pose ensembles, where only
+     * the coordinates change from one structure to the next. Each column
+     * that is identical to the same column of the previous f_m_ct block
+     * is replaced by a reference to it, and the parsed copy is released.
+     *
+     * The indexed blocks of each f_m_ct block are materialized as it is
+     * read, so this suits files that are read in full. Shared columns
+     * should not be changed in place.
+     *
+     * With the buffered parser, when an indexed block has the same columns
+     * and row count as in the previous f_m_ct block, only the coordinate
+     * columns and those listed in 'parsed_columns' are parsed. The tokens
+     * of every other column are compared with those of the previous block,
+     * and the column is reused if they are identical. The tokens of the
+     * previous f_m_ct block are kept for this.
+     */
+    void
+    setEnsembleSharing(bool ensemble_sharing,
+                       const std::vector<std::string>& parsed_columns = {})
+    {
+        auto& options = m_indexed_block_options;
+        options.ensemble_sharing = ensemble_sharing;
+        options.ensemble_parsed_columns.clear();
+        for (const auto& name : parsed_columns) {
+            options.ensemble_parsed_columns.push_back(NameTable::intern(name));
+        }
+        m_ensemble_previous = nullptr;
+        m_ensemble_tokens = nullptr;
+    }
+
+    /**
+     * Convert the columns of indexed blocks on up to 'threads' threads as
+     * the blocks are materialized from their tokens, or on as many threads
+     * as the hardware supports if 'threads' is zero. Only blocks with tens
+     * of thousands of values are split, one set of columns per thread, so
+     * this suits single large structures with many columns. It applies to
+     * the buffered parser.
+     */
+    void setMaterializationThreads(size_t threads)
+    {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        m_indexed_block_options.materialization_threads = threads;
+    }
+
+    /**
+     * Tokenize the values of indexed blocks on up to 'threads' threads, or
+     * on as many threads as the hardware supports if 'threads' is zero.
+     * Only blocks with tens of thousands of values are split. Each block
+     * is read into memory in full, then split into chunks of lines that
+     * are tokenized separately. If a quoted string or comment spans two
+     * chunks, or the tokens don't add up to the block's row count, the
+     * block is tokenized on the calling thread instead. It applies to the
+     * buffered parser.
+     */
+    void setTokenizationThreads(size_t threads)
+    {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        m_indexed_block_options.tokenization_threads = threads;
+    }
+
+    std::shared_ptr<Block> blockBody(const std::string& name)
+    {
+        return blockBody(NameTable::intern(name));
+    }
+
+    std::shared_ptr<Block> blockBody(InternedName name);
 
     IndexedBlock* indexedBlock(const std::string& name, size_t size);
 
@@ -310,6 +923,14 @@ class EXPORT_MAEPARSER MaeParser
 
     std::shared_ptr<Block> outerBlock();
 
+    /**
+     * Read the next outer block, reporting its contents to 'handler' as
+     * they are read rather than building a Block. Values are passed as
+     * views of the parser's buffer. Return false at the end of the input.
+     * The options for building blocks don't apply.
+     */
+    bool outerBlock(MaeHandler& handler);
+
     /**
      * Read a block name or a closing '}'. The argument 'indexed' is set to
      * a positive integer value indicating the number of rows, or zero if
@@ -317,8 +938,20 @@ class EXPORT_MAEPARSER MaeParser
      *
      * Return the block name or NULL if the closing '}' was found.
      */
-    std::string blockBeginning(int* indexed);
+    std::string blockBeginning(int* indexed)
+    {
+        return internedBlockBeginning(indexed).str();
+    }
 
+    /**
+     * As blockBeginning(), but return the interned block name.
+     */
+    InternedName internedBlockBeginning(int* indexed);
+
+    /**
+     * Read a property key. Return a copy of the name, or NULL if the
+     * name/value separator was found.
+     */
     std::shared_ptr<std::string> property();
 
     /**
@@ -327,6 +960,12 @@ class EXPORT_MAEPARSER MaeParser
      */
     void properties(std::vector<std::shared_ptr<std::string>>* property_names);
 
+    /**
+     * Read a list of properties, ending at the name/value separator.
+     * Populate the provided std::vector of interned names.
+     */
+    void properties(std::vector<InternedName>* property_names);
+
     /**
      * Read (and throw away) any whitespace.
      */
@@ -351,7 +990,8 @@ class EXPORT_MAEPARSER DirectMaeParser : public MaeParser
   private:
     IndexedBlockParser* getIndexedBlockParser() override
     {
-        return new DirectIndexedBlockParser();
+        return new DirectIndexedBlockParser(m_arena,
+                                            m_indexed_block_options);
     }
 };
 
@@ -0,0 +1,243 @@
+#include "MaeTokenCursor.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "MaeParser.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+MaeTokenCursor::MaeTokenCursor(const std::shared_ptr<std::istream>& stream,
+                               size_t buffer_size)
+    : m_buffer(*stream, buffer_size), m_stream(stream)
+{
+    m_frames.reserve(8);
+    m_buffer.load();
+}
+
+MaeTokenCursor::MaeTokenCursor(FILE* file, size_t buffer_size)
+    : m_buffer(file, buffer_size)
+{
+    if (file == nullptr) {
+        std::string msg("Bad file argument");
+        if (errno != 0) {
+            msg += ": ";
+            msg += strerror(errno);
+        } else {
+            msg += ".";
+        }
+        throw std::runtime_error(msg);
+    }
+    m_frames.reserve(8);
+    m_buffer.load();
+}
+
+void MaeTokenCursor::blockBegin(InternedName name, bool indexed, size_t rows)
+{
+    m_frames.push_back({name, indexed, rows});
+    m_keys.clear();
+    m_values_read = 0;
+    m_state = State::KEYS;
+
+    m_token.type = MaeTokenType::BLOCK_BEGIN;
+    m_token.name = name;
+    m_token.text = name ? boost::string_view(name.str()) : "";
+    m_token.depth = m_frames.size() - 1;
+    m_token.indexed = indexed;
+    m_token.row = rows;
+}
+
+void MaeTokenCursor::blockEnd()
+{
+    const auto& frame = m_frames.back();
+    m_token.type = MaeTokenType::BLOCK_END;
+    m_token.name = frame.name;
+    m_token.text = frame.name ? boost::string_view(frame.name.str()) : "";
+    m_token.depth = m_frames.size() - 1;
+    m_token.indexed = frame.indexed;
+    m_token.row = 0;
+
+    m_frames.pop_back();
+    m_state = m_frames.empty() ? State::OUTER : State::BODY;
+}
+
+void MaeTokenCursor::outerBlockBeginning()
+{
+    InternedName name;
+    char* save = m_buffer.current;
+    if (*m_buffer.current != '{') {
+        if (*m_buffer.current != 'f' && *m_buffer.current != 'p') {
+            goto bad_format;
+        }
+        ++m_buffer.current;
+        if (!character('_', m_buffer, save) ||
+            !property_key_author_name(m_buffer, save)) {
+            goto bad_format;
+        }
+        name = NameTable::intern(save, m_buffer.current - save);
+        schrodinger::mae::whitespace(m_buffer);
+    }
+    if (!character('{', m_buffer)) {
+        throw read_exception(m_buffer, "Missing '{' for outer block.");
+    }
+    blockBegin(name, false, 0);
+    return;
+
+bad_format:
+    throw read_exception(m_buffer, "Bad format for outer block name; "
+                                   "must be (f|p)_<author>_<name>.");
+}
+
+void MaeTokenCursor::blockBeginning()
+{
+    char* save = m_buffer.current;
+    if (!property_key_author_name(m_buffer, save)) {
+        throw read_exception(m_buffer, "Bad format for block name; "
+                                       "must be <author>_<name>.");
+    }
+    const auto name = NameTable::intern(save, m_buffer.current - save);
+    schrodinger::mae::whitespace(m_buffer);
+
+    bool indexed = false;
+    int rows = 0;
+    if (character('[', m_buffer)) {
+        indexed = true;
+        schrodinger::mae::whitespace(m_buffer);
+        rows = parse_value<int>(m_buffer);
+        schrodinger::mae::whitespace(m_buffer);
+        if (!character(']', m_buffer)) {
+            throw read_exception(m_buffer, "Bad block index; missing ']'.");
+        }
+        schrodinger::mae::whitespace(m_buffer);
+    }
+    if (!character('{', m_buffer)) {
+        throw read_exception(m_buffer, "Missing '{' for block.");
+    }
+    blockBegin(name, indexed, rows < 0 ? 0 : static_cast<size_t>(rows));
+}
+
+bool MaeTokenCursor::value()
+{
+    const auto& frame = m_frames.back();
+    const size_t row_length = m_keys.size() + 1;
+    const size_t count =
+        frame.indexed ? frame.rows * row_length : m_keys.size();
+    if (m_values_read == count) {
+        return false;
+    }
+
+    schrodinger::mae::whitespace(m_buffer);
+    char* save = m_buffer.current;
+    value_token(m_buffer, save);
+    const size_t index = m_values_read++;
+
+    m_token.type = MaeTokenType::VALUE;
+    m_token.text = boost::string_view(save, m_buffer.current - save);
+    m_token.depth = m_frames.size() - 1;
+    m_token.indexed = frame.indexed;
+    if (frame.indexed) {
+        m_token.row = index / row_length;
+        const size_t column = index % row_length;
+        // The row index isn't a value of any column.
+        if (column == 0) {
+            return value();
+        }
+        m_token.name = m_keys[column - 1];
+    } else {
+        m_token.row = 0;
+        m_token.name = m_keys[index];
+    }
+    return true;
+}
+
+const MaeToken& MaeTokenCursor::next()
+{
+    switch (m_state) {
+    case State::OUTER:
+        schrodinger::mae::whitespace(m_buffer);
+        if (!m_buffer.load()) {
+            m_token = MaeToken();
+            return m_token;
+        }
+        outerBlockBeginning();
+        return m_token;
+
+    case State::KEYS: {
+        schrodinger::mae::whitespace(m_buffer);
+        const auto key = interned_property_key(m_buffer);
+        m_token.depth = m_frames.size() - 1;
+        m_token.indexed = m_frames.back().indexed;
+        m_token.row = 0;
+        if (key) {
+            m_keys.push_back(key);
+            m_token.type = MaeTokenType::KEY;
+            m_token.name = key;
+            m_token.text = key.str();
+        } else {
+            triple_colon(m_buffer);
+            m_token.type = MaeTokenType::SEPARATOR;
+            m_token.name = InternedName();
+            m_token.text = ":::";
+            m_state = State::VALUES;
+        }
+        return m_token;
+    }
+
+    case State::VALUES:
+        if (value()) {
+            return m_token;
+        }
+        if (m_frames.back().indexed) {
+            schrodinger::mae::whitespace(m_buffer);
+            triple_colon(m_buffer);
+            m_token.type = MaeTokenType::SEPARATOR;
+            m_token.name = InternedName();
+            m_token.text = ":::";
+            m_token.depth = m_frames.size() - 1;
+            m_token.indexed = true;
+            m_token.row = 0;
+            m_state = State::INDEXED_END;
+            return m_token;
+        }
+        m_state = State::BODY;
+        return next();
+
+    case State::INDEXED_END:
+        schrodinger::mae::whitespace(m_buffer);
+        if (!character('}', m_buffer)) {
+            throw read_exception(m_buffer, "Missing '}' for indexed block.");
+        }
+        blockEnd();
+        return m_token;
+
+    case State::BODY:
+        schrodinger::mae::whitespace(m_buffer);
+        if (!m_buffer.load()) {
+            throw read_exception(m_buffer, "Missing '}' for block.");
+        }
+        if (*m_buffer.current == '}') {
+            ++m_buffer.current;
+            blockEnd();
+        } else {
+            blockBeginning();
+        }
+        return m_token;
+    }
+    return m_token;
+}
+
+void MaeTokenCursor::skipBlock()
+{
+    const size_t depth = m_frames.size();
+    while (m_frames.size() >= depth && depth > 0) {
+        next();
+    }
+}
+
+} // namespace mae
+} // namespace schrodinger
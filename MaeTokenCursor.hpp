@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <istream>
+#include <memory>
+#include <vector>
+
+#include <boost/utility/string_view.hpp>
+
+#include "Buffer.hpp"
+#include "MaeHandler.hpp"
+#include "MaeParserConfig.hpp"
+#include "NameTable.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+enum class MaeTokenType {
+    BLOCK_BEGIN, ///< An outer, nested or indexed block's opening '{'.
+    KEY,         ///< A property key.
+    SEPARATOR,   ///< A ':::' separator.
+    VALUE,       ///< A property value or an indexed block value.
+    BLOCK_END,   ///< A block's closing '}'.
+    END          ///< The end of the input.
+};
+
+/**
+ * A token read by a MaeTokenCursor. Its text is only valid until the next
+ * call to MaeTokenCursor::next().
+ */
+class EXPORT_MAEPARSER MaeToken
+{
+  public:
+    MaeTokenType type{MaeTokenType::END};
+
+    /// The block name for BLOCK_BEGIN and BLOCK_END (empty for the unnamed
+    /// format block), the key for KEY and the token for VALUE, including
+    /// any quotes.
+    boost::string_view text;
+
+    /// The interned block name for BLOCK_BEGIN and BLOCK_END (null for the
+    /// unnamed format block), the key for KEY and the key of the value's
+    /// column for VALUE.
+    InternedName name;
+
+    /// The nesting depth of the token's block; outer blocks are at zero.
+    size_t depth{0};
+
+    /// For BLOCK_BEGIN and for values, whether the block is indexed.
+    bool indexed{false};
+
+    /// For BLOCK_BEGIN of an indexed block, its row count. For a value of
+    /// an indexed block, its zero-based row.
+    size_t row{0};
+
+    /**
+     * Return a VALUE token's text as a MaeValue, for conversion.
+     */
+    MaeValue value() const { return MaeValue(text); }
+};
+
+/**
+ * A pull cursor over the tokens of an MAE file, for extractors that only
+ * need a few values and would rather not build blocks or implement a
+ * MaeHandler.
+ *
+ * Each block is reported as BLOCK_BEGIN, its keys, a SEPARATOR, its values,
+ * any nested blocks and then BLOCK_END. An indexed block's values are
+ * followed by its closing SEPARATOR, and the row index that starts each of
+ * its rows isn't reported.
+ *
+ * Tokens are views of the cursor's buffer and names are interned, so
+ * nothing is allocated per token once the names of a file have been seen.
+ */
+class EXPORT_MAEPARSER MaeTokenCursor
+{
+  private:
+    enum class State { OUTER, KEYS, VALUES, INDEXED_END, BODY };
+
+    struct Frame {
+        InternedName name;
+        bool indexed;
+        size_t rows;
+    };
+
+    Buffer m_buffer;
+    std::shared_ptr<std::istream> m_stream;
+    State m_state{State::OUTER};
+    std::vector<Frame> m_frames;
+
+    /// The keys of the innermost block, and the number of its values read.
+    std::vector<InternedName> m_keys;
+    size_t m_values_read{0};
+
+    MaeToken m_token;
+
+    void blockBegin(InternedName name, bool indexed, size_t rows);
+    void blockEnd();
+    void outerBlockBeginning();
+    void blockBeginning();
+    bool value();
+
+  public:
+    explicit MaeTokenCursor(const std::shared_ptr<std::istream>& stream,
+                            size_t buffer_size = BufferLoader::DEFAULT_SIZE);
+
+    explicit MaeTokenCursor(FILE* file,
+                            size_t buffer_size = BufferLoader::DEFAULT_SIZE);
+
+    MaeTokenCursor(const MaeTokenCursor&) = delete;
+    MaeTokenCursor& operator=(const MaeTokenCursor&) = delete;
+
+    /**
+     * Read the next token. Once the input is exhausted, every call returns
+     * an END token. Throws a read_exception if the input is badly formed.
+     */
+    const MaeToken& next();
+
+    /**
+     * Skip the rest of the innermost block that has begun, up to and
+     * including its BLOCK_END. Does nothing between outer blocks.
+     */
+    void skipBlock();
+
+    /**
+     * Return the line number of the cursor's position in the input.
+     */
+    size_t lineNumber() const { return m_buffer.line_number; }
+};
+
+} // namespace mae
+} // namespace schrodinger
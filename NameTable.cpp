@@ -0,0 +1,118 @@
+#include "NameTable.hpp"
+
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
+
+namespace schrodinger
+{
+namespace mae
+{
+
+namespace
+{
+struct StringViewHash {
+    size_t operator()(const boost::string_view& s) const
+    {
+        return boost::hash_range(s.begin(), s.end());
+    }
+};
+
+// The keys of the index view the strings they map to, so they remain valid
+// for as long as the strings do.
+using NameIndex =
+    std::unordered_map<boost::string_view, const std::string*, StringViewHash>;
+
+class SharedNameTable
+{
+  public:
+    std::mutex mutex;
+    // A deque never relocates its elements, so pointers to them are stable.
+    std::deque<std::string> names;
+    NameIndex index;
+};
+
+SharedNameTable& shared_table()
+{
+    static SharedNameTable table;
+    return table;
+}
+
+NameIndex& local_cache()
+{
+    thread_local NameIndex cache;
+    return cache;
+}
+} // namespace
+
+std::ostream& operator<<(std::ostream& os, const InternedName& name)
+{
+    return os << name.str();
+}
+
+InternedName NameTable::intern(const char* data, size_t length)
+{
+    const boost::string_view key(data, length);
+
+    auto& cache = local_cache();
+    auto cached = cache.find(key);
+    if (cached != cache.end()) {
+        return InternedName(cached->second);
+    }
+
+    const std::string* name = nullptr;
+    {
+        auto& table = shared_table();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto iter = table.index.find(key);
+        if (iter != table.index.end()) {
+            name = iter->second;
+        } else {
+            table.names.emplace_back(data, length);
+            name = &table.names.back();
+            table.index.emplace(boost::string_view(*name), name);
+        }
+    }
+
+    cache.emplace(boost::string_view(*name), name);
+    return InternedName(name);
+}
+
+InternedName NameTable::find(const char* data, size_t length)
+{
+    const boost::string_view key(data, length);
+
+    auto& cache = local_cache();
+    auto cached = cache.find(key);
+    if (cached != cache.end()) {
+        return InternedName(cached->second);
+    }
+
+    const std::string* name = nullptr;
+    {
+        auto& table = shared_table();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto iter = table.index.find(key);
+        if (iter == table.index.end()) {
+            return InternedName();
+        }
+        name = iter->second;
+    }
+
+    cache.emplace(boost::string_view(*name), name);
+    return InternedName(name);
+}
+
+size_t NameTable::size()
+{
+    auto& table = shared_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.names.size();
+}
+
+} // namespace mae
+} // namespace schrodinger
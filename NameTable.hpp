@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+#include "MaeParserConfig.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+/**
+ * A handle to a property or block name stored in the process-wide NameTable.
+ *
+ * Copying an InternedName copies a single pointer. Since every distinct name
+ * is stored exactly once, equality is a pointer comparison. Ordering follows
+ * the string values, so maps keyed by InternedName iterate in the same order
+ * as maps keyed by std::string.
+ *
+ * A default constructed InternedName is null and must not be dereferenced;
+ * it orders before every other name.
+ */
+class EXPORT_MAEPARSER InternedName
+{
+  private:
+    const std::string* m_name{nullptr};
+
+    explicit InternedName(const std::string* name) : m_name(name) {}
+
+    friend class NameTable;
+
+  public:
+    InternedName() = default;
+
+    const std::string& str() const
+    {
+        assert(m_name != nullptr);
+        return *m_name;
+    }
+
+    const char* c_str() const { return str().c_str(); }
+
+    size_t size() const { return str().size(); }
+
+    explicit operator bool() const { return m_name != nullptr; }
+
+    bool operator==(const InternedName& rhs) const
+    {
+        return m_name == rhs.m_name;
+    }
+
+    bool operator!=(const InternedName& rhs) const
+    {
+        return m_name != rhs.m_name;
+    }
+
+    /**
+     * Order by string value, with null names first.
+     */
+    bool operator<(const InternedName& rhs) const
+    {
+        if (m_name == rhs.m_name || rhs.m_name == nullptr) {
+            return false;
+        }
+        return m_name == nullptr || *m_name < *rhs.m_name;
+    }
+
+    char operator[](size_t index) const { return str()[index]; }
+
+    /**
+     * Hash by identity; distinct names are distinct objects.
+     */
+    size_t hash() const { return std::hash<const std::string*>()(m_name); }
+};
+
+inline bool operator==(const InternedName& lhs, const std::string& rhs)
+{
+    return lhs && lhs.str() == rhs;
+}
+
+inline bool operator==(const std::string& lhs, const InternedName& rhs)
+{
+    return rhs == lhs;
+}
+
+inline bool operator!=(const InternedName& lhs, const std::string& rhs)
+{
+    return !(lhs == rhs);
+}
+
+inline bool operator!=(const std::string& lhs, const InternedName& rhs)
+{
+    return !(rhs == lhs);
+}
+
+EXPORT_MAEPARSER std::ostream& operator<<(std::ostream& os,
+                                          const InternedName& name);
+
+/**
+ * The process-wide table of property and block names.
+ *
+ * Names are added once and never removed, so the storage behind an
+ * InternedName is valid for the lifetime of the process. The table is safe
+ * to use from multiple threads; each thread keeps a private cache in front of
+ * the shared table so that lookups of previously seen names neither lock nor
+ * allocate.
+ */
+class EXPORT_MAEPARSER NameTable
+{
+  public:
+    NameTable() = delete;
+
+    /**
+     * Return the interned copy of the provided name, adding it to the table
+     * if it hasn't been seen before.
+     */
+    static InternedName intern(const char* data, size_t length);
+
+    static InternedName intern(const std::string& name)
+    {
+        return intern(name.data(), name.size());
+    }
+
+    /**
+     * Return the interned copy of the provided name, or a null InternedName
+     * if the name has never been interned. The table is not modified.
+     */
+    static InternedName find(const char* data, size_t length);
+
+    static InternedName find(const std::string& name)
+    {
+        return find(name.data(), name.size());
+    }
+
+    /**
+     * Return the number of distinct names interned so far.
+     */
+    static size_t size();
+};
+
+/**
+ * A property or block name resolved once for repeated lookups.
+ *
+ * Block and IndexedBlock lookups by PropertyKey hash a single pointer rather
+ * than comparing strings, so hot loops that access the same properties for
+ * every structure should construct their keys once, outside the loop:
+ *
+ *     const PropertyKey score("r_i_docking_score");
+ *     while ((b = r.next(CT_BLOCK)) != nullptr) {
+ *         if (b->hasRealProperty(score)) {
+ *             total += b->getRealProperty(score);
+ *         }
+ *     }
+ */
+class EXPORT_MAEPARSER PropertyKey : public InternedName
+{
+  public:
+    explicit PropertyKey(const std::string& name)
+        : InternedName(NameTable::intern(name))
+    {
+    }
+
+    explicit PropertyKey(const char* name) : PropertyKey(std::string(name)) {}
+
+    explicit PropertyKey(InternedName name) : InternedName(name) {}
+};
+
+} // namespace mae
+} // namespace schrodinger
+
+namespace std
+{
+template <> struct hash<schrodinger::mae::InternedName> {
+    size_t operator()(const schrodinger::mae::InternedName& name) const
+    {
+        return name.hash();
+    }
+};
+} // namespace std
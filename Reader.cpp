@@ -78,5 +78,11 @@ std::shared_ptr<Block> Reader::next(const std::string& outer_block_name)
     } while (block != nullptr && block->getName() != outer_block_name);
     return block;
 }
+
+bool Reader::next(MaeHandler& handler)
+{
+    m_mae_parser->whitespace();
+    return m_mae_parser->outerBlock(handler);
+}
 } // namespace mae
 } // namespace schrodinger
@@ -3,9 +3,11 @@
 #include <cstdio>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Buffer.hpp"
 #include "MaeBlock.hpp"
+#include "MaeHandler.hpp"
 #include "MaeParser.hpp"
 #include "MaeParserConfig.hpp"
 
@@ -35,6 +37,124 @@ class EXPORT_MAEPARSER Reader
     Reader(std::shared_ptr<MaeParser> mae_parser);
 
     std::shared_ptr<Block> next(const std::string& outer_block_name);
+
+    /**
+     * Report the next outer block to 'handler' rather than building it.
+     * Return false at the end of the input. See
+     * MaeParser::outerBlock(MaeHandler&).
+     */
+    bool next(MaeHandler& handler);
+
+    /**
+     * Allocate each block returned by next() from its own Arena.
+     * See MaeParser::setArenaAllocation().
+     */
+    void setArenaAllocation(bool arena_allocation)
+    {
+        m_mae_parser->setArenaAllocation(arena_allocation);
+    }
+
+    /**
+     * Store string columns of indexed blocks as IndexedStringViewProperty
+     * objects. See MaeParser::setStringViews().
+     */
+    void setStringViews(bool string_views)
+    {
+        m_mae_parser->setStringViews(string_views);
+    }
+
+    /**
+     * Dictionary encode string columns of indexed blocks where that saves
+     * memory. See MaeParser::setDictionaryEncoding().
+     */
+    void setDictionaryEncoding(bool dictionary_encoding)
+    {
+        m_mae_parser->setDictionaryEncoding(dictionary_encoding);
+    }
+
+    /**
+     * Store indexed block columns in compact encodings.
+     * See MaeParser::setCompactColumns().
+     */
+    void setCompactColumns(bool compact_columns)
+    {
+        m_mae_parser->setCompactColumns(compact_columns);
+    }
+
+    /**
+     * Store compact real columns in single precision.
+     * See MaeParser::setSinglePrecisionReals().
+     */
+    void setSinglePrecisionReals(bool single_precision_reals)
+    {
+        m_mae_parser->setSinglePrecisionReals(single_precision_reals);
+    }
+
+    /**
+     * Fill coordinate buffers while parsing.
+     * See MaeParser::setCoordinateBuffers().
+     */
+    void setCoordinateBuffers(bool coordinate_buffers,
+                              CoordinateLayout layout = CoordinateLayout::SOA)
+    {
+        m_mae_parser->setCoordinateBuffers(coordinate_buffers, layout);
+    }
+
+    /**
+     * Build a StructureView for each f_m_ct block.
+     * See MaeParser::setStructureViews().
+     */
+    void setStructureViews(bool structure_views)
+    {
+        m_mae_parser->setStructureViews(structure_views);
+    }
+
+    /**
+     * Build a BondAdjacency for each f_m_ct block.
+     * See MaeParser::setBondAdjacency().
+     */
+    void setBondAdjacency(bool bond_adjacency)
+    {
+        m_mae_parser->setBondAdjacency(bond_adjacency);
+    }
+
+    /**
+     * Build a SpatialGrid for each f_m_ct block.
+     * See MaeParser::setSpatialGrid().
+     */
+    void setSpatialGrid(bool spatial_grid, double cell_size = 4.0)
+    {
+        m_mae_parser->setSpatialGrid(spatial_grid, cell_size);
+    }
+
+    /**
+     * Share identical indexed block columns between consecutive f_m_ct
+     * blocks. See MaeParser::setEnsembleSharing().
+     */
+    void
+    setEnsembleSharing(bool ensemble_sharing,
+                       const std::vector<std::string>& parsed_columns = {})
+    {
+        m_mae_parser->setEnsembleSharing(ensemble_sharing, parsed_columns);
+    }
+
+    /**
+     * Convert the columns of large indexed blocks on several threads.
+     * See MaeParser::setMaterializationThreads().
+     */
+    void setMaterializationThreads(size_t threads)
+    {
+        m_mae_parser->setMaterializationThreads(threads);
+    }
+
+    /**
+     * Tokenize large indexed blocks on several threads.
+     * See MaeParser::setTokenizationThreads().
+     */
+    void setTokenizationThreads(size_t threads)
+    {
+        m_mae_parser->setTokenizationThreads(threads);
+    }
 };
 
 } // namespace mae
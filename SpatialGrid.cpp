@@ -0,0 +1,251 @@
+#include "SpatialGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+namespace
+{
+// The grid is coarsened until it has at most this many cells per atom.
+const double max_cells_per_atom = 8.0;
+
+bool is_defined(const Coordinates& coordinates, size_t atom)
+{
+    return std::isfinite(coordinates(atom, 0)) &&
+           std::isfinite(coordinates(atom, 1)) &&
+           std::isfinite(coordinates(atom, 2));
+}
+
+std::shared_ptr<const Coordinates> atom_coordinates(const Block& ct)
+{
+    const auto indexed_blocks = ct.getIndexedBlockMap();
+    if (indexed_blocks == nullptr) {
+        return nullptr;
+    }
+    return indexed_blocks->getCoordinates(PropertyKey(ATOM_BLOCK),
+                                          CoordinateLayout::SOA);
+}
+} // namespace
+
+SpatialGrid::SpatialGrid(std::shared_ptr<const Coordinates> coordinates,
+                         double cell_size)
+    : m_coordinates(std::move(coordinates)), m_cell_size(cell_size),
+      m_origin{0.0, 0.0, 0.0}, m_dims{1, 1, 1}, m_cell_offsets(2, 0)
+{
+    if (!(cell_size > 0.0)) {
+        throw std::invalid_argument("Cell size must be positive.");
+    }
+    const size_t size = m_coordinates ? m_coordinates->size() : 0;
+    if (size > UINT32_MAX) {
+        throw std::out_of_range("Too many atoms for a spatial grid.");
+    }
+
+    double low[3];
+    double high[3];
+    std::fill(low, low + 3, std::numeric_limits<double>::infinity());
+    std::fill(high, high + 3, -std::numeric_limits<double>::infinity());
+    size_t defined = 0;
+    for (size_t i = 0; i < size; ++i) {
+        const auto& c = *m_coordinates;
+        if (!is_defined(c, i)) {
+            continue;
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            low[axis] = std::min(low[axis], c(i, axis));
+            high[axis] = std::max(high[axis], c(i, axis));
+        }
+        ++defined;
+    }
+    if (defined == 0) {
+        return;
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        if (!std::isfinite(high[axis] - low[axis])) {
+            throw std::out_of_range("Atoms too far apart for a spatial grid.");
+        }
+    }
+
+    // Coarsen the grid if the atoms are sparse; computed in doubles since
+    // the cell counts of a very sparse grid may not fit in a size_t.
+    const double max_cells = max_cells_per_atom * defined + 64.0;
+    double cells[3];
+    for (;;) {
+        for (int axis = 0; axis < 3; ++axis) {
+            cells[axis] =
+                std::floor((high[axis] - low[axis]) / m_cell_size) + 1.0;
+        }
+        if (cells[0] * cells[1] * cells[2] <= max_cells) {
+            break;
+        }
+        m_cell_size *= 2.0;
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        m_origin[axis] = low[axis];
+        m_dims[axis] = static_cast<size_t>(cells[axis]);
+    }
+
+    // Bucket the atoms by cell with a counting sort.
+    const size_t cell_count = m_dims[0] * m_dims[1] * m_dims[2];
+    const auto none = std::numeric_limits<size_t>::max();
+    std::vector<size_t> atom_cells(size, none);
+    m_cell_offsets.assign(cell_count + 1, 0);
+    for (size_t i = 0; i < size; ++i) {
+        const auto& c = *m_coordinates;
+        if (!is_defined(c, i)) {
+            continue;
+        }
+        atom_cells[i] = cell(cellIndex(c(i, 0), 0), cellIndex(c(i, 1), 1),
+                             cellIndex(c(i, 2), 2));
+        ++m_cell_offsets[atom_cells[i] + 1];
+    }
+    for (size_t i = 0; i < cell_count; ++i) {
+        m_cell_offsets[i + 1] += m_cell_offsets[i];
+    }
+    m_atoms.resize(defined);
+    std::vector<uint32_t> next(m_cell_offsets.begin(),
+                               m_cell_offsets.end() - 1);
+    for (size_t i = 0; i < size; ++i) {
+        if (atom_cells[i] != none) {
+            m_atoms[next[atom_cells[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+}
+
+SpatialGrid::SpatialGrid(const Block& ct, double cell_size)
+    : SpatialGrid(atom_coordinates(ct), cell_size)
+{
+}
+
+size_t SpatialGrid::cellIndex(double coordinate, int axis) const
+{
+    const double index =
+        std::floor((coordinate - m_origin[axis]) / m_cell_size);
+    if (!(index > 0.0)) {
+        return 0;
+    }
+    return static_cast<size_t>(
+        std::min(index, static_cast<double>(m_dims[axis] - 1)));
+}
+
+double SpatialGrid::distanceSquared(uint32_t atom, double x, double y,
+                                    double z) const
+{
+    const auto& c = *m_coordinates;
+    const double dx = c(atom, 0) - x;
+    const double dy = c(atom, 1) - y;
+    const double dz = c(atom, 2) - z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+void SpatialGrid::withinRadius(double x, double y, double z, double radius,
+                               std::vector<uint32_t>& atoms) const
+{
+    if (m_atoms.empty() || !(radius >= 0.0) || std::isnan(x) ||
+        std::isnan(y) || std::isnan(z)) {
+        return;
+    }
+    const double point[3] = {x, y, z};
+    size_t low[3];
+    size_t high[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        low[axis] = cellIndex(point[axis] - radius, axis);
+        high[axis] = cellIndex(point[axis] + radius, axis);
+    }
+    const double radius_squared = radius * radius;
+    for (size_t iz = low[2]; iz <= high[2]; ++iz) {
+        for (size_t iy = low[1]; iy <= high[1]; ++iy) {
+            for (size_t ix = low[0]; ix <= high[0]; ++ix) {
+                const size_t c = cell(ix, iy, iz);
+                for (auto i = m_cell_offsets[c]; i < m_cell_offsets[c + 1];
+                     ++i) {
+                    if (distanceSquared(m_atoms[i], x, y, z) <=
+                        radius_squared) {
+                        atoms.push_back(m_atoms[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::vector<uint32_t> SpatialGrid::nearest(double x, double y, double z,
+                                           size_t k) const
+{
+    std::vector<uint32_t> atoms;
+    if (k == 0 || m_atoms.empty() || std::isnan(x) || std::isnan(y) ||
+        std::isnan(z)) {
+        return atoms;
+    }
+    const double point[3] = {x, y, z};
+    long center[3];
+    size_t max_ring = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        const size_t index = cellIndex(point[axis], axis);
+        center[axis] = static_cast<long>(index);
+        max_ring =
+            std::max(max_ring, std::max(index, m_dims[axis] - 1 - index));
+    }
+
+    // Search rings of cells around the point's cell, keeping the k best
+    // candidates in a max-heap. Every cell of ring s + 1 is at least
+    // s * cell size away, which bounds the search.
+    std::priority_queue<std::pair<double, uint32_t>> best;
+    for (size_t ring = 0; ring <= max_ring; ++ring) {
+        const long s = static_cast<long>(ring);
+        long low[3];
+        long high[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            low[axis] = std::max(center[axis] - s, 0L);
+            high[axis] = std::min(center[axis] + s,
+                                  static_cast<long>(m_dims[axis]) - 1);
+        }
+        for (long iz = low[2]; iz <= high[2]; ++iz) {
+            for (long iy = low[1]; iy <= high[1]; ++iy) {
+                for (long ix = low[0]; ix <= high[0]; ++ix) {
+                    if (std::labs(ix - center[0]) != s &&
+                        std::labs(iy - center[1]) != s &&
+                        std::labs(iz - center[2]) != s) {
+                        continue;
+                    }
+                    const size_t c = cell(ix, iy, iz);
+                    for (auto i = m_cell_offsets[c];
+                         i < m_cell_offsets[c + 1]; ++i) {
+                        const std::pair<double, uint32_t> candidate(
+                            distanceSquared(m_atoms[i], x, y, z), m_atoms[i]);
+                        if (best.size() < k) {
+                            best.push(candidate);
+                        } else if (candidate < best.top()) {
+                            best.pop();
+                            best.push(candidate);
+                        }
+                    }
+                }
+            }
+        }
+        const double bound = ring * m_cell_size;
+        if (best.size() == k && best.top().first <= bound * bound) {
+            break;
+        }
+    }
+
+    atoms.resize(best.size());
+    for (auto i = atoms.size(); i > 0; --i) {
+        atoms[i - 1] = best.top().second;
+        best.pop();
+    }
+    return atoms;
+}
+
+} // namespace mae
+} // namespace schrodinger
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Coordinates.hpp"
+#include "MaeParserConfig.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+class Block;
+
+/**
+ * A uniform grid of cubic cells over a structure's atom coordinates, for
+ * radius and nearest neighbor queries.
+ *
+ * Atoms are bucketed by cell with a counting sort, so building the grid
+ * takes linear time. If the atoms are spread so thinly that there would be
+ * many more cells than atoms, the cell size is increased. Atoms with
+ * undefined (NaN) or infinite coordinates are left out of the grid. Atoms
+ * are indexed from zero.
+ */
+class EXPORT_MAEPARSER SpatialGrid
+{
+  private:
+    std::shared_ptr<const Coordinates> m_coordinates;
+    double m_cell_size;
+    double m_origin[3];
+    size_t m_dims[3];
+    std::vector<uint32_t> m_cell_offsets;
+    std::vector<uint32_t> m_atoms;
+
+    /**
+     * Return the cell of a coordinate along an axis, clamped to the grid.
+     */
+    size_t cellIndex(double coordinate, int axis) const;
+
+    size_t cell(size_t ix, size_t iy, size_t iz) const
+    {
+        return (iz * m_dims[1] + iy) * m_dims[0] + ix;
+    }
+
+    double distanceSquared(uint32_t atom, double x, double y, double z) const;
+
+  public:
+    /**
+     * Build a grid over the provided coordinates, or an empty grid if they
+     * are null. Throws std::invalid_argument if 'cell_size' isn't positive.
+     */
+    explicit SpatialGrid(std::shared_ptr<const Coordinates> coordinates,
+                         double cell_size = 4.0);
+
+    /**
+     * Build a grid over the coordinate columns of a block's m_atom block.
+     * For blocks read by a buffered parser only the coordinate columns are
+     * parsed, straight from the file's tokens.
+     */
+    explicit SpatialGrid(const Block& ct, double cell_size = 4.0);
+
+    SpatialGrid(const SpatialGrid&) = delete;
+    SpatialGrid& operator=(const SpatialGrid&) = delete;
+
+    /**
+     * Return the number of atoms in the grid.
+     */
+    size_t size() const { return m_atoms.size(); }
+
+    double cellSize() const { return m_cell_size; }
+
+    std::shared_ptr<const Coordinates> coordinates() const
+    {
+        return m_coordinates;
+    }
+
+    /**
+     * Append the atoms within 'radius' of a point to 'atoms', in no
+     * particular order.
+     */
+    void withinRadius(double x, double y, double z, double radius,
+                      std::vector<uint32_t>& atoms) const;
+
+    /**
+     * Return the 'k' atoms nearest to a point, nearest first, or every atom
+     * if there are fewer than 'k'.
+     */
+    std::vector<uint32_t> nearest(double x, double y, double z,
+                                  size_t k) const;
+};
+
+} // namespace mae
+} // namespace schrodinger
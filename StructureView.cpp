@@ -0,0 +1,35 @@
+#include "StructureView.hpp"
+
+#include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+StructureView::StructureView(const Block& ct, CoordinateLayout layout)
+{
+    const auto indexed_blocks = ct.getIndexedBlockMap();
+    if (indexed_blocks == nullptr) {
+        return;
+    }
+
+    const PropertyKey atoms(ATOM_BLOCK);
+    indexed_blocks->getIntColumn(atoms, PropertyKey(ATOM_ATOMIC_NUM),
+                                 m_atomic_numbers);
+    indexed_blocks->getIntColumn(atoms, PropertyKey(ATOM_FORMAL_CHARGE),
+                                 m_formal_charges);
+    m_coordinates = indexed_blocks->getCoordinates(atoms, layout);
+
+    const PropertyKey bonds(BOND_BLOCK);
+    indexed_blocks->getIntColumn(bonds, PropertyKey(BOND_ATOM_1),
+                                 m_bond_atom_1);
+    indexed_blocks->getIntColumn(bonds, PropertyKey(BOND_ATOM_2),
+                                 m_bond_atom_2);
+    indexed_blocks->getIntColumn(bonds, PropertyKey(BOND_ORDER),
+                                 m_bond_order);
+}
+
+} // namespace mae
+} // namespace schrodinger
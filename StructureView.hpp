@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Coordinates.hpp"
+#include "MaeParserConfig.hpp"
+
+namespace schrodinger
+{
+namespace mae
+{
+
+class Block;
+
+/**
+ * The core atom and bond columns of an f_m_ct block, as contiguous typed
+ * arrays.
+ *
+ * The columns are those named in MaeConstants.hpp: ATOM_ATOMIC_NUM,
+ * ATOM_FORMAL_CHARGE and the coordinates of ATOM_BLOCK, and BOND_ATOM_1,
+ * BOND_ATOM_2 and BOND_ORDER of BOND_BLOCK. Atom indices in the bond arrays
+ * are 1-based, as in the file. Undefined int values are zero, and undefined
+ * coordinates are NaN. Missing columns are empty, except that coordinates()
+ * is null.
+ *
+ * A StructureView is a snapshot; it does not reflect later changes to the
+ * block it was built from.
+ */
+class EXPORT_MAEPARSER StructureView
+{
+  private:
+    std::vector<int> m_atomic_numbers;
+    std::vector<int> m_formal_charges;
+    std::shared_ptr<const Coordinates> m_coordinates;
+    std::vector<int> m_bond_atom_1;
+    std::vector<int> m_bond_atom_2;
+    std::vector<int> m_bond_order;
+
+  public:
+    /**
+     * Build a view of a block's indexed blocks. For blocks read by a
+     * buffered parser the columns are parsed straight from the file's
+     * tokens, without materializing the generic IndexedBlocks.
+     */
+    explicit StructureView(const Block& ct,
+                           CoordinateLayout layout = CoordinateLayout::SOA);
+
+    StructureView(const StructureView&) = delete;
+    StructureView& operator=(const StructureView&) = delete;
+
+    size_t atomCount() const { return m_atomic_numbers.size(); }
+
+    size_t bondCount() const { return m_bond_order.size(); }
+
+    const std::vector<int>& atomicNumbers() const { return m_atomic_numbers; }
+
+    const std::vector<int>& formalCharges() const { return m_formal_charges; }
+
+    std::shared_ptr<const Coordinates> coordinates() const
+    {
+        return m_coordinates;
+    }
+
+    const std::vector<int>& bondAtom1() const { return m_bond_atom_1; }
+
+    const std::vector<int>& bondAtom2() const { return m_bond_atom_2; }
+
+    const std::vector<int>& bondOrder() const { return m_bond_order; }
+};
+
+} // namespace mae
+} // namespace schrodinger
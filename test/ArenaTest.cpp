@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "Arena.hpp"
+#include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+#include "MaeParser.hpp"
+#include "Reader.hpp"
+
+using namespace schrodinger::mae;
+
+const boost::filesystem::path test_samples_path(TEST_SAMPLES_PATH);
+const std::string uncompressed_sample =
+    (test_samples_path / "test.mae").string();
+
+BOOST_AUTO_TEST_SUITE(ArenaSuite)
+
+BOOST_AUTO_TEST_CASE(AllocationsAreAligned)
+{
+    Arena arena(1024);
+    for (size_t alignment : {1, 2, 4, 8, 16, 32}) {
+        arena.allocate(3, 1);
+        auto* ptr = arena.allocate(10, alignment);
+        BOOST_REQUIRE_EQUAL(reinterpret_cast<std::uintptr_t>(ptr) % alignment,
+                            0u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AllocationsSpanChunks)
+{
+    Arena arena(1024);
+    const auto initial = arena.capacity();
+
+    // A large request gets a chunk of its own.
+    auto* big = static_cast<char*>(arena.allocate(100000));
+    big[99999] = 'x';
+    BOOST_REQUIRE(arena.capacity() >= initial + 100000);
+
+    // Small requests keep filling fresh chunks.
+    std::vector<char*> small;
+    for (int i = 0; i < 100; ++i) {
+        auto* ptr = static_cast<char*>(arena.allocate(100));
+        ptr[0] = ptr[99] = static_cast<char>(i);
+        small.push_back(ptr);
+    }
+    for (int i = 0; i < 100; ++i) {
+        BOOST_REQUIRE_EQUAL(small[i][0], static_cast<char>(i));
+        BOOST_REQUIRE_EQUAL(small[i][99], static_cast<char>(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AllocatorKeepsArenaAlive)
+{
+    auto arena = std::make_shared<Arena>();
+    auto block = allocate_shared_in<Block>(arena, NameTable::intern("f_m_ct"),
+                                           arena);
+    std::weak_ptr<Arena> weak = arena;
+    arena = nullptr;
+    BOOST_REQUIRE(!weak.expired());
+
+    block->setIntProperty("i_m_arena", 7);
+    block->setStringProperty("s_m_arena", "value");
+    BOOST_REQUIRE_EQUAL(block->getIntProperty("i_m_arena"), 7);
+    BOOST_REQUIRE_EQUAL(block->getStringProperty("s_m_arena"), "value");
+    BOOST_REQUIRE(block->getArena() == weak.lock());
+
+    block = nullptr;
+    BOOST_REQUIRE(weak.expired());
+}
+
+BOOST_AUTO_TEST_CASE(ArenaParsingMatchesHeapParsing)
+{
+    Reader heap_reader(uncompressed_sample);
+    Reader arena_reader(uncompressed_sample);
+    arena_reader.setArenaAllocation(true);
+
+    std::shared_ptr<Block> heap_block;
+    std::shared_ptr<Block> previous;
+    size_t count = 0;
+    while ((heap_block = heap_reader.next(CT_BLOCK)) != nullptr) {
+        auto arena_block = arena_reader.next(CT_BLOCK);
+        BOOST_REQUIRE(arena_block != nullptr);
+        BOOST_REQUIRE(heap_block->getArena() == nullptr);
+        BOOST_REQUIRE(arena_block->getArena() != nullptr);
+        BOOST_REQUIRE(*arena_block == *heap_block);
+
+        auto atoms = arena_block->getIndexedBlock(ATOM_BLOCK);
+        BOOST_REQUIRE(atoms->getArena() == arena_block->getArena());
+
+        // The block is materialized once, rather than on every request.
+        const auto capacity = arena_block->getArena()->capacity();
+        for (int i = 0; i < 10; ++i) {
+            BOOST_REQUIRE(arena_block->getIndexedBlock(ATOM_BLOCK) == atoms);
+        }
+        BOOST_REQUIRE_EQUAL(arena_block->getArena()->capacity(), capacity);
+
+        // Every structure gets its own region.
+        if (previous != nullptr) {
+            BOOST_REQUIRE(previous->getArena() != arena_block->getArena());
+        }
+        previous = arena_block;
+        ++count;
+    }
+    BOOST_REQUIRE(count > 0);
+    BOOST_REQUIRE(arena_reader.next(CT_BLOCK) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(DirectArenaParsingMatchesHeapParsing)
+{
+    auto arena_parser = std::make_shared<DirectMaeParser>(
+        std::make_shared<std::ifstream>(uncompressed_sample));
+    arena_parser->setArenaAllocation(true);
+    Reader arena_reader(arena_parser);
+    Reader heap_reader(std::make_shared<DirectMaeParser>(
+        std::make_shared<std::ifstream>(uncompressed_sample)));
+
+    std::shared_ptr<Block> heap_block;
+    while ((heap_block = heap_reader.next(CT_BLOCK)) != nullptr) {
+        auto arena_block = arena_reader.next(CT_BLOCK);
+        BOOST_REQUIRE(arena_block != nullptr);
+        BOOST_REQUIRE(*arena_block == *heap_block);
+        BOOST_REQUIRE(arena_block->getIndexedBlock(BOND_BLOCK)->getArena() ==
+                      arena_block->getArena());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+#include <boost/test/unit_test.hpp>
+
+#include "Bitmap.hpp"
+
+using namespace schrodinger::mae;
+
+BOOST_AUTO_TEST_SUITE(BitmapSuite)
+
+BOOST_AUTO_TEST_CASE(SetAndTest)
+{
+    Bitmap bits(130);
+    BOOST_REQUIRE_EQUAL(bits.size(), 130u);
+    BOOST_REQUIRE(bits.none());
+    bits.set(0);
+    bits.set(63);
+    bits.set(64);
+    bits.set(129);
+    BOOST_REQUIRE(bits.test(0));
+    BOOST_REQUIRE(!bits.test(1));
+    BOOST_REQUIRE(bits.test(63));
+    BOOST_REQUIRE(bits.test(64));
+    BOOST_REQUIRE(bits.test(129));
+    BOOST_REQUIRE_EQUAL(bits.count(), 4u);
+
+    bits.reset(63);
+    bits.set(1, true);
+    BOOST_REQUIRE(!bits.test(63));
+    BOOST_REQUIRE(bits.test(1));
+    BOOST_REQUIRE_EQUAL(bits.count(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(ArrowLayout)
+{
+    // Bit i is bit i % 64 of word i / 64, least significant first.
+    Bitmap bits(70, true);
+    BOOST_REQUIRE_EQUAL(bits.words()[0], ~uint64_t(0));
+    // Unused bits of the last word are zero.
+    BOOST_REQUIRE_EQUAL(bits.words()[1], uint64_t(0x3F));
+    BOOST_REQUIRE(bits.all());
+    BOOST_REQUIRE_EQUAL(bits.count(), 70u);
+
+    bits.reset(2);
+    BOOST_REQUIRE_EQUAL(bits.words()[0], ~uint64_t(4));
+}
+
+BOOST_AUTO_TEST_CASE(PushBackAndResize)
+{
+    Bitmap bits;
+    for (size_t i = 0; i < 100; ++i) {
+        bits.push_back(i % 3 == 0);
+    }
+    BOOST_REQUIRE_EQUAL(bits.size(), 100u);
+    BOOST_REQUIRE_EQUAL(bits.count(), 34u);
+
+    bits.resize(200, true);
+    BOOST_REQUIRE_EQUAL(bits.count(), 134u);
+    BOOST_REQUIRE(bits.test(99));
+    BOOST_REQUIRE(!bits.test(98));
+    BOOST_REQUIRE(bits.test(100));
+
+    bits.resize(10);
+    BOOST_REQUIRE_EQUAL(bits.count(), 4u);
+    bits.resize(100);
+    BOOST_REQUIRE_EQUAL(bits.count(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(Combine)
+{
+    Bitmap a(100);
+    Bitmap b(100);
+    for (size_t i = 0; i < 100; ++i) {
+        a.set(i, i % 2 == 0);
+        b.set(i, i % 3 == 0);
+    }
+
+    Bitmap both = a;
+    both &= b;
+    BOOST_REQUIRE_EQUAL(both.count(), 17u);
+
+    Bitmap either = a;
+    either |= b;
+    BOOST_REQUIRE_EQUAL(either.count(), 67u);
+
+    BOOST_REQUIRE(both != either);
+    BOOST_REQUIRE_THROW(a &= Bitmap(99), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
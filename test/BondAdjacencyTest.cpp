@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "BondAdjacency.hpp"
+#include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+#include "MaeParser.hpp"
+#include "Reader.hpp"
+
+using namespace schrodinger::mae;
+
+namespace
+{
+const boost::filesystem::path test_samples_path(TEST_SAMPLES_PATH);
+const std::string uncompressed_sample =
+    (test_samples_path / "test.mae").string();
+
+std::vector<uint32_t> neighbors_of(const BondAdjacency& adjacency,
+                                   size_t atom)
+{
+    const auto& offsets = adjacency.offsets();
+    return std::vector<uint32_t>(
+        adjacency.neighbors().begin() + offsets[atom],
+        adjacency.neighbors().begin() + offsets[atom + 1]);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(BondAdjacencySuite)
+
+BOOST_AUTO_TEST_CASE(BuildFromColumns)
+{
+    // A chain 1-2-3 with a double bond 1=4, where 1-2 is listed twice.
+    const std::vector<int> atom_1{1, 2, 2, 1};
+    const std::vector<int> atom_2{2, 3, 1, 4};
+    const std::vector<int> order{1, 1, 1, 2};
+    BondAdjacency adjacency(5, atom_1, atom_2, order);
+
+    BOOST_REQUIRE_EQUAL(adjacency.atomCount(), 5u);
+    BOOST_REQUIRE_EQUAL(adjacency.offsets().size(), 6u);
+    BOOST_REQUIRE_EQUAL(adjacency.neighbors().size(), 6u);
+    BOOST_REQUIRE(neighbors_of(adjacency, 0) ==
+                  std::vector<uint32_t>({1, 3}));
+    BOOST_REQUIRE(neighbors_of(adjacency, 1) ==
+                  std::vector<uint32_t>({0, 2}));
+    BOOST_REQUIRE_EQUAL(adjacency.degree(2), 1u);
+    BOOST_REQUIRE_EQUAL(adjacency.degree(4), 0u);
+
+    // Atom 1 to atom 4 is the double bond of m_bond row 3.
+    const size_t entry = adjacency.offsets()[0] + 1;
+    BOOST_REQUIRE_EQUAL(adjacency.orders()[entry], 2);
+    BOOST_REQUIRE_EQUAL(adjacency.bonds()[entry], 3u);
+
+    BOOST_REQUIRE_THROW(BondAdjacency(3, atom_1, atom_2, order),
+                        std::out_of_range);
+    BOOST_REQUIRE_THROW(BondAdjacency(5, atom_1, atom_2, {1}),
+                        std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(ParsedBondAdjacency)
+{
+    for (bool direct : {false, true}) {
+        auto stream = std::make_shared<std::ifstream>(uncompressed_sample);
+        std::shared_ptr<MaeParser> parser;
+        if (direct) {
+            parser = std::make_shared<DirectMaeParser>(stream);
+        } else {
+            parser = std::make_shared<MaeParser>(stream);
+        }
+        Reader r(parser);
+        r.setBondAdjacency(true);
+
+        std::shared_ptr<Block> b;
+        while ((b = r.next(CT_BLOCK)) != nullptr) {
+            const auto adjacency = b->getBondAdjacency();
+            BOOST_REQUIRE(b->getBondAdjacency() == adjacency);
+            const auto atoms = b->getIndexedBlock(ATOM_BLOCK);
+            BOOST_REQUIRE_EQUAL(adjacency->atomCount(), atoms->size());
+
+            // Every m_bond row is in the adjacency of both of its atoms.
+            const auto bonds = b->getIndexedBlock(BOND_BLOCK);
+            const auto from = bonds->getIntProperty(BOND_ATOM_1);
+            const auto to = bonds->getIntProperty(BOND_ATOM_2);
+            for (size_t i = 0; i < bonds->size(); ++i) {
+                const auto neighbors =
+                    neighbors_of(*adjacency, (*from)[i] - 1);
+                BOOST_REQUIRE(std::find(neighbors.begin(), neighbors.end(),
+                                        (*to)[i] - 1) != neighbors.end());
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UnusableBondColumns)
+{
+    // The m_bond block has no i_m_order column.
+    const std::string mae = "f_m_ct {\n"
+                            "  s_m_title\n"
+                            "  :::\n"
+                            "  test\n"
+                            "  m_atom[2] {\n"
+                            "    r_m_x_coord\n"
+                            "    :::\n"
+                            "    1 0.0\n"
+                            "    2 1.0\n"
+                            "    :::\n"
+                            "  }\n"
+                            "  m_bond[1] {\n"
+                            "    i_m_from\n"
+                            "    i_m_to\n"
+                            "    :::\n"
+                            "    1 1 2\n"
+                            "    :::\n"
+                            "  }\n"
+                            "}\n";
+    for (bool direct : {false, true}) {
+        auto stream = std::make_shared<std::stringstream>(mae);
+        std::shared_ptr<MaeParser> parser;
+        if (direct) {
+            parser = std::make_shared<DirectMaeParser>(stream);
+        } else {
+            parser = std::make_shared<MaeParser>(stream);
+        }
+        Reader r(parser);
+        r.setBondAdjacency(true);
+
+        const auto b = r.next(CT_BLOCK);
+        BOOST_REQUIRE(b != nullptr);
+        BOOST_REQUIRE_EQUAL(b->getIndexedBlock(BOND_BLOCK)->size(), 1u);
+        BOOST_REQUIRE_THROW(b->getBondAdjacency(), std::invalid_argument);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BuiltBondAdjacency)
+{
+    Reader parsed_reader(uncompressed_sample);
+    parsed_reader.setBondAdjacency(true);
+    const auto parsed = parsed_reader.next(CT_BLOCK)->getBondAdjacency();
+
+    Reader r(uncompressed_sample);
+    const auto built = r.next(CT_BLOCK)->getBondAdjacency();
+    BOOST_REQUIRE(built->offsets() == parsed->offsets());
+    BOOST_REQUIRE(built->neighbors() == parsed->neighbors());
+    BOOST_REQUIRE(built->orders() == parsed->orders());
+
+    Block empty(CT_BLOCK);
+    BOOST_REQUIRE_EQUAL(empty.getBondAdjacency()->atomCount(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
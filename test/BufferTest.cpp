@@ -1,7 +1,10 @@
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 
 #include <map>
+#include <string>
 #include <sstream>
 #include <stdexcept>
 
@@ -172,4 +175,57 @@ BOOST_AUTO_TEST_CASE(NewlineCase1)
     }
 }
 
+BOOST_AUTO_TEST_CASE(TokenBufferListIndex)
+{
+    BufferData first(8);
+    std::memcpy(first.begin(), "ab cd ef", 8);
+    BufferData second(4);
+    std::memcpy(second.begin(), "ghij", 4);
+
+    TokenBufferList tokens;
+    tokens.reserve(4);
+    BOOST_REQUIRE_EQUAL(tokens.indexCapacityBytes(), 4 * 8u);
+
+    tokens.appendBufferData(first);
+    tokens.setTokenIndices(0, 2);
+    tokens.setTokenIndices(3, 5);
+    tokens.appendBufferData(second);
+    tokens.setTokenIndices(1, 4);
+    BOOST_REQUIRE_EQUAL(tokens.size(), 3u);
+
+    const char* expected[] = {"ab", "cd", "hij"};
+    auto token_buffer = tokens.begin();
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const char* data = nullptr;
+        size_t length = 0;
+        tokens.getData(i, &data, &length);
+        BOOST_REQUIRE_EQUAL(std::string(data, length), expected[i]);
+        tokens.getData(i, &data, &length, token_buffer);
+        BOOST_REQUIRE_EQUAL(std::string(data, length), expected[i]);
+    }
+
+    const size_t too_large =
+        static_cast<size_t>(std::numeric_limits<uint32_t>::max()) + 1;
+    BOOST_REQUIRE_THROW(tokens.setTokenIndices(0, too_large),
+                        std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(BufferDataTerminator)
+{
+    BufferData data(8);
+    std::memcpy(data.begin(), "abcdefgh", 8);
+    BOOST_REQUIRE_EQUAL(data.begin()[8], '\0');
+    data.resize(3);
+    BOOST_REQUIRE_EQUAL(data.size(), 3u);
+    BOOST_REQUIRE_EQUAL(data.begin()[3], '\0');
+    BOOST_REQUIRE_THROW(data.resize(9), std::runtime_error);
+
+    // A short read leaves the terminator at the end of the loaded data.
+    std::stringstream ss("ab\n");
+    Buffer b(ss, 16);
+    BOOST_REQUIRE(b.load());
+    BOOST_REQUIRE_EQUAL(b.end - b.begin, 3);
+    BOOST_REQUIRE_EQUAL(*b.end, '\0');
+}
+
 BOOST_AUTO_TEST_SUITE_END()
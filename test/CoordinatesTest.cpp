@@ -0,0 +1,192 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "Coordinates.hpp"
+#include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+#include "MaeParser.hpp"
+#include "Reader.hpp"
+
+using namespace schrodinger::mae;
+
+namespace
+{
+const boost::filesystem::path test_samples_path(TEST_SAMPLES_PATH);
+const std::string uncompressed_sample =
+    (test_samples_path / "test.mae").string();
+const std::string compressed_sample =
+    (test_samples_path / "test2.maegz").string();
+
+bool is_aligned(const double* ptr)
+{
+    return reinterpret_cast<std::uintptr_t>(ptr) % Coordinates::ALIGNMENT ==
+           0;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(CoordinatesSuite)
+
+BOOST_AUTO_TEST_CASE(Layouts)
+{
+    Coordinates soa(10);
+    BOOST_REQUIRE(soa.layout() == CoordinateLayout::SOA);
+    BOOST_REQUIRE_EQUAL(soa.size(), 10u);
+    BOOST_REQUIRE_EQUAL(soa.stride(), 16u);
+    BOOST_REQUIRE_EQUAL(soa.increment(), 1u);
+    for (size_t axis = 0; axis < 3; ++axis) {
+        BOOST_REQUIRE(is_aligned(soa.axis(axis)));
+    }
+    soa(3, 1) = 2.5;
+    BOOST_REQUIRE_EQUAL(soa.y()[3], 2.5);
+    BOOST_REQUIRE_EQUAL(soa.data()[16 + 3], 2.5);
+    // Padding is zeroed.
+    BOOST_REQUIRE_EQUAL(soa.x()[15], 0.0);
+
+    auto arena = std::make_shared<Arena>();
+    Coordinates packed(10, CoordinateLayout::PACKED, arena);
+    BOOST_REQUIRE(is_aligned(packed.data()));
+    BOOST_REQUIRE_EQUAL(packed.increment(), 3u);
+    packed(3, 2) = -1.0;
+    BOOST_REQUIRE_EQUAL(packed.data()[3 * 3 + 2], -1.0);
+    BOOST_REQUIRE_EQUAL(packed.z()[3 * 3], -1.0);
+
+    Coordinates empty(0);
+    BOOST_REQUIRE(is_aligned(empty.data()));
+}
+
+BOOST_AUTO_TEST_CASE(BlockCoordinates)
+{
+    IndexedBlock ib(ATOM_BLOCK);
+    BOOST_REQUIRE(ib.getCoordinates() == nullptr);
+
+    std::vector<double> xs{1.0, 2.0, 3.0};
+    std::vector<double> ys{4.0, 5.0, 6.0};
+    std::vector<double> zs{7.0, 8.0, 0.0};
+    Bitmap z_validity(3, true);
+    z_validity.reset(2);
+    ib.setRealProperty(ATOM_X_COORD,
+                       std::make_shared<IndexedRealProperty>(xs, Bitmap()));
+    ib.setRealProperty(ATOM_Y_COORD,
+                       std::make_shared<IndexedRealProperty>(ys, Bitmap()));
+    BOOST_REQUIRE(ib.getCoordinates() == nullptr);
+    ib.setRealProperty(ATOM_Z_COORD,
+                       std::make_shared<IndexedRealProperty>(zs, z_validity));
+
+    auto soa = ib.getCoordinates();
+    BOOST_REQUIRE_EQUAL(soa->size(), 3u);
+    BOOST_REQUIRE_EQUAL(soa->x()[2], 3.0);
+    BOOST_REQUIRE_EQUAL(soa->y()[0], 4.0);
+    BOOST_REQUIRE(std::isnan(soa->z()[2]));
+
+    auto packed = ib.getCoordinates(CoordinateLayout::PACKED);
+    const std::vector<double> expected{1.0, 4.0, 7.0, 2.0, 5.0, 8.0};
+    for (size_t i = 0; i < expected.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(packed->data()[i], expected[i]);
+    }
+
+    // A stored buffer is returned as is until a coordinate column changes.
+    ib.setCoordinates(soa);
+    BOOST_REQUIRE(ib.getCoordinates() == soa);
+    BOOST_REQUIRE(ib.getCoordinates(CoordinateLayout::PACKED) != soa);
+    std::vector<double> moved{0.0, 0.0, 0.0};
+    ib.setRealProperty(ATOM_X_COORD,
+                       std::make_shared<IndexedRealProperty>(moved, Bitmap()));
+    BOOST_REQUIRE(ib.getCoordinates() != soa);
+    BOOST_REQUIRE_EQUAL(ib.getCoordinates()->x()[2], 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(ParsedCoordinates)
+{
+    for (auto layout : {CoordinateLayout::SOA, CoordinateLayout::PACKED}) {
+        for (bool direct : {false, true}) {
+            auto stream = std::make_shared<std::ifstream>(uncompressed_sample);
+            std::shared_ptr<MaeParser> parser;
+            if (direct) {
+                parser = std::make_shared<DirectMaeParser>(stream);
+            } else {
+                parser = std::make_shared<MaeParser>(stream);
+            }
+            Reader r(parser);
+            r.setCoordinateBuffers(true, layout);
+
+            std::shared_ptr<Block> b;
+            while ((b = r.next(CT_BLOCK)) != nullptr) {
+                auto atoms = b->getIndexedBlock(ATOM_BLOCK);
+                auto coordinates = atoms->getCoordinates(layout);
+                BOOST_REQUIRE(coordinates->layout() == layout);
+                BOOST_REQUIRE(atoms->getCoordinates(layout) == coordinates);
+                BOOST_REQUIRE(is_aligned(coordinates->data()));
+
+                auto xs = atoms->getRealProperty(ATOM_X_COORD);
+                auto zs = atoms->getRealProperty(ATOM_Z_COORD);
+                BOOST_REQUIRE_EQUAL(coordinates->size(), xs->size());
+                for (size_t i = 0; i < xs->size(); ++i) {
+                    BOOST_REQUIRE_EQUAL((*coordinates)(i, 0), (*xs)[i]);
+                    BOOST_REQUIRE_EQUAL((*coordinates)(i, 2), (*zs)[i]);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SinglePrecisionCoordinates)
+{
+    // The buffer holds the same rounded values as compacted columns.
+    Reader r(uncompressed_sample);
+    r.setCompactColumns(true);
+    r.setSinglePrecisionReals(true);
+    r.setCoordinateBuffers(true);
+
+    size_t rounded = 0;
+    std::shared_ptr<Block> b;
+    while ((b = r.next(CT_BLOCK)) != nullptr) {
+        auto atoms = b->getIndexedBlock(ATOM_BLOCK);
+        auto coordinates = atoms->getCoordinates();
+        auto xs = atoms->getRealProperty(ATOM_X_COORD);
+        if (xs->encoding() == IndexedEncoding::FLOAT32) {
+            ++rounded;
+        }
+        for (size_t i = 0; i < xs->size(); ++i) {
+            BOOST_REQUIRE_EQUAL((*coordinates)(i, 0), xs->get(i));
+        }
+    }
+    BOOST_REQUIRE(rounded > 0);
+}
+
+// Demonstrates reading each structure's coordinates through one
+// interleaved buffer rather than three columns, as in UsageDemo.cpp.
+BOOST_AUTO_TEST_CASE(PackedCoordinatesDemo)
+{
+    Reader r(compressed_sample);
+
+    std::shared_ptr<Block> b;
+    while ((b = r.next(CT_BLOCK)) != nullptr) {
+        const auto atom_data = b->getIndexedBlock(ATOM_BLOCK);
+        // The x, y and z coordinate columns, interleaved
+        const auto coordinates =
+            atom_data->getCoordinates(CoordinateLayout::PACKED);
+        const auto size = coordinates->size();
+
+        std::vector<std::array<double, 3>> xyzs;
+        const double* xyz = coordinates->data();
+        for (size_t i = 0; i < size; ++i) {
+            xyzs.push_back({{xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]}});
+        }
+
+        const auto ys = atom_data->getRealProperty(ATOM_Y_COORD);
+        BOOST_REQUIRE_EQUAL(xyzs.size(), ys->size());
+        for (size_t i = 0; i < size; ++i) {
+            BOOST_REQUIRE_EQUAL(xyzs[i][1], ys->at(i));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
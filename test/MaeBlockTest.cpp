@@ -1,6 +1,8 @@
+#include <cmath>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
 
 #include <boost/test/unit_test.hpp>
 
@@ -118,6 +120,22 @@ BOOST_AUTO_TEST_CASE(maeIndexedRealProperty)
         BOOST_REQUIRE(irp.isDefined(2));
         BOOST_REQUIRE_CLOSE(irp[2], 3.0, tolerance);
     }
+    {
+        std::vector<double> dv{1.0, 0.0, 3.0};
+        mae::IndexedRealProperty irp(dv);
+        BOOST_REQUIRE(irp.nullIndices() == nullptr);
+        irp[0] = 2.0;
+        BOOST_REQUIRE_CLOSE(irp.at(0), 2.0, tolerance);
+
+        // The bitset is owned by the property and follows its changes.
+        irp.undefine(1);
+        const auto* is_null = irp.nullIndices();
+        BOOST_REQUIRE(is_null != nullptr);
+        BOOST_REQUIRE(irp.nullIndices() == is_null);
+        BOOST_REQUIRE(is_null->test(1));
+        irp.set(1, 5.0);
+        BOOST_REQUIRE(!irp.nullIndices()->test(1));
+    }
 }
 
 BOOST_AUTO_TEST_CASE(maeIndexedBlock)
@@ -185,6 +203,255 @@ BOOST_AUTO_TEST_CASE(maeIndexedBlockBool)
     }
 }
 
+BOOST_AUTO_TEST_CASE(maeBitPackedBool)
+{
+    using namespace mae;
+    std::vector<BoolProperty> flags;
+    std::vector<BoolProperty> others;
+    Bitmap validity(150, true);
+    for (size_t i = 0; i < 150; ++i) {
+        flags.push_back(i % 2 == 0);
+        others.push_back(i % 3 == 0);
+    }
+    validity.reset(0);
+    validity.reset(149);
+
+    IndexedBoolProperty ibp(flags, validity);
+    IndexedBoolProperty reference(others, Bitmap());
+    std::vector<BoolProperty> copy(ibp.data());
+    IndexedBoolProperty dense(copy, validity);
+
+    ibp.compact();
+    reference.compact();
+    BOOST_REQUIRE(ibp.encoding() == IndexedEncoding::BITS);
+    BOOST_REQUIRE(ibp == dense);
+
+    const auto& packed = ibp;
+    BOOST_REQUIRE(!packed.isDefined(0));
+    BOOST_REQUIRE_THROW(packed[0], std::runtime_error);
+    BOOST_REQUIRE_EQUAL(packed[2], static_cast<BoolProperty>(true));
+    BOOST_REQUIRE_EQUAL(packed.at(3), static_cast<BoolProperty>(false));
+    BOOST_REQUIRE_EQUAL(packed.get(4), static_cast<BoolProperty>(true));
+    BOOST_REQUIRE_EQUAL(packed.at(149, 7), 7);
+    BOOST_REQUIRE_EQUAL(packed.countDefined(), 148u);
+    BOOST_REQUIRE_EQUAL(packed.countTrue(), 74u);
+    BOOST_REQUIRE(ibp.encoding() == IndexedEncoding::BITS);
+
+    auto both = ibp.trueValues();
+    both &= reference.trueValues();
+    BOOST_REQUIRE_EQUAL(both.count(), 24u);
+
+    // Mutable access switches back to one value per row.
+    ibp[3] = true;
+    BOOST_REQUIRE(ibp.encoding() == IndexedEncoding::DENSE);
+    BOOST_REQUIRE_EQUAL(packed[3], static_cast<BoolProperty>(true));
+    BOOST_REQUIRE_EQUAL(ibp.countTrue(), 75u);
+    ibp.set(3, false);
+    BOOST_REQUIRE_EQUAL(ibp.countTrue(), 74u);
+
+    // The validity bitmap may run past the values.
+    std::vector<BoolProperty> trues(3, 1);
+    Bitmap long_validity(5, true);
+    long_validity.reset(1);
+    IndexedBoolProperty trailing(trues, long_validity);
+    BOOST_REQUIRE_EQUAL(trailing.countTrue(), 2u);
+    BOOST_REQUIRE_EQUAL(trailing.trueValues().size(), 3u);
+    trailing.compact();
+    BOOST_REQUIRE_EQUAL(trailing.countTrue(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(maeSparseProperty)
+{
+    using namespace mae;
+    std::vector<int> values(100, 0);
+    Bitmap validity(100);
+    for (size_t i = 0; i < 100; i += 20) {
+        values[i] = static_cast<int>(i) + 1;
+        validity.set(i);
+    }
+    std::vector<int> copy(values);
+    IndexedIntProperty dense(copy, validity);
+    IndexedIntProperty iip(values, validity);
+
+    iip.compact();
+    BOOST_REQUIRE(iip.encoding() == IndexedEncoding::SPARSE);
+    BOOST_REQUIRE(iip == dense);
+
+    const auto& sparse = iip;
+    BOOST_REQUIRE_EQUAL(sparse.size(), 100u);
+    BOOST_REQUIRE_EQUAL(sparse.countDefined(), 5u);
+    BOOST_REQUIRE_EQUAL(sparse[0], 1);
+    BOOST_REQUIRE_EQUAL(sparse.at(40), 41);
+    BOOST_REQUIRE_EQUAL(sparse.get(80), 81);
+    BOOST_REQUIRE(!sparse.isDefined(41));
+    BOOST_REQUIRE_THROW(sparse[41], std::runtime_error);
+    BOOST_REQUIRE_EQUAL(sparse.at(41, -1), -1);
+    BOOST_REQUIRE_EQUAL(sparse.data()[60], 61);
+    BOOST_REQUIRE(iip.encoding() == IndexedEncoding::SPARSE);
+
+    iip.set(41, 5);
+    BOOST_REQUIRE(iip.encoding() == IndexedEncoding::DENSE);
+    BOOST_REQUIRE_EQUAL(sparse[41], 5);
+    BOOST_REQUIRE_EQUAL(sparse[20], 21);
+
+    // Strings are worth storing sparsely at a higher density than ints.
+    std::vector<std::string> labels(10);
+    Bitmap label_validity(10);
+    labels[3] = "label";
+    labels[6] = "other";
+    label_validity.set(3);
+    label_validity.set(6);
+    IndexedStringProperty isp(labels, label_validity);
+    isp.compact();
+    BOOST_REQUIRE(isp.encoding() == IndexedEncoding::SPARSE);
+    BOOST_REQUIRE_EQUAL(static_cast<const IndexedStringProperty&>(isp)[3],
+                        "label");
+
+    // Mostly defined columns stay dense.
+    std::vector<double> reals{0.1, 0.2, 0.3, 0.4, 0.5,
+                              0.6, 0.7, 0.8, 0.9, 1.1};
+    Bitmap real_validity(10, true);
+    real_validity.reset(0);
+    IndexedRealProperty irp(reals, real_validity);
+    irp.compact();
+    BOOST_REQUIRE(irp.encoding() == IndexedEncoding::DENSE);
+}
+
+BOOST_AUTO_TEST_CASE(maeNarrowProperty)
+{
+    using namespace mae;
+
+    // The constructors take ownership of the values, so pass copies.
+    // Values alternate, so that no run-length encoding applies.
+    std::vector<int> small;
+    for (int i = 0; i < 100; ++i) {
+        small.push_back(i % 2 ? -3 : 3);
+    }
+    small[50] = 127;
+    auto values = small;
+    IndexedIntProperty int8(values, Bitmap(100, true));
+    int8.compact();
+    BOOST_REQUIRE(int8.encoding() == IndexedEncoding::INT8);
+    const auto& cint8 = int8;
+    // Const reads decode values in place, rather than referring to a copy.
+    static_assert(std::is_same<decltype(cint8[50]), int>::value,
+                  "narrow values are read by value");
+    BOOST_REQUIRE_EQUAL(cint8[50], 127);
+    BOOST_REQUIRE_EQUAL(cint8.at(1), -3);
+    BOOST_REQUIRE(int8.encoding() == IndexedEncoding::INT8);
+    BOOST_REQUIRE_EQUAL(cint8.get(0), 3);
+    BOOST_REQUIRE_EQUAL(cint8.data()[99], -3);
+
+    std::vector<int> medium(small);
+    medium[10] = -30000;
+    values = medium;
+    IndexedIntProperty int16(values, Bitmap(100, true));
+    int16.compact();
+    BOOST_REQUIRE(int16.encoding() == IndexedEncoding::INT16);
+    BOOST_REQUIRE_EQUAL(int16.get(10), -30000);
+    BOOST_REQUIRE(int16 == IndexedIntProperty(medium, Bitmap(100, true)));
+
+    std::vector<int> large(small);
+    large[0] = 1 << 20;
+    IndexedIntProperty int32(large, Bitmap(100, true));
+    int32.compact();
+    BOOST_REQUIRE(int32.encoding() == IndexedEncoding::DENSE);
+
+    // Writing densifies the values.
+    int8.set(1, 1000);
+    BOOST_REQUIRE(int8.encoding() == IndexedEncoding::DENSE);
+    BOOST_REQUIRE_EQUAL(int8.get(1), 1000);
+    BOOST_REQUIRE_EQUAL(int8.get(50), 127);
+
+    // A property can be compacted, and expanded, again.
+    int8.set(1, -3);
+    int8.compact();
+    BOOST_REQUIRE(int8.encoding() == IndexedEncoding::INT8);
+    BOOST_REQUIRE_EQUAL(cint8.data()[50], 127);
+
+    // Reals are only rounded to single precision on request.
+    std::vector<double> halves{0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 4.5};
+    IndexedRealProperty exact(halves, Bitmap(9, true));
+    exact.compact();
+    BOOST_REQUIRE(exact.encoding() == IndexedEncoding::FLOAT32);
+    BOOST_REQUIRE_EQUAL(exact.get(3), 2.0);
+
+    std::vector<double> tenths{0.1, 0.2, 0.3, 0.4, 0.5,
+                               0.6, 0.7, 0.8, 0.9, 1.1};
+    IndexedRealProperty inexact(tenths, Bitmap(10, true));
+    inexact.compact();
+    BOOST_REQUIRE(inexact.encoding() == IndexedEncoding::DENSE);
+    inexact.compact(RealPrecision::SINGLE);
+    BOOST_REQUIRE(inexact.encoding() == IndexedEncoding::FLOAT32);
+    BOOST_REQUIRE_EQUAL(inexact.get(3), static_cast<float>(0.4));
+
+    tenths = {1e300, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.1};
+    IndexedRealProperty huge(tenths, Bitmap(10, true));
+    huge.compact(RealPrecision::SINGLE);
+    BOOST_REQUIRE(huge.encoding() == IndexedEncoding::DENSE);
+}
+
+BOOST_AUTO_TEST_CASE(maeConstantAndRunProperty)
+{
+    using namespace mae;
+
+    // The constructors take ownership of the values, so pass copies.
+    std::vector<int> colors(50, 4);
+    Bitmap validity(50, true);
+    validity.reset(7);
+    colors[7] = 0;
+    auto values = colors;
+    IndexedIntProperty constant(values, validity);
+    constant.compact();
+    BOOST_REQUIRE(constant.encoding() == IndexedEncoding::CONSTANT);
+    BOOST_REQUIRE(constant == IndexedIntProperty(colors, validity));
+
+    const auto& cconstant = constant;
+    BOOST_REQUIRE_EQUAL(cconstant[49], 4);
+    BOOST_REQUIRE(!cconstant.isDefined(7));
+    BOOST_REQUIRE_EQUAL(cconstant.at(7, -1), -1);
+    BOOST_REQUIRE_EQUAL(cconstant.data()[7], 0);
+    BOOST_REQUIRE_EQUAL(cconstant.data()[8], 4);
+
+    // An all false bool column is constant too.
+    std::vector<BoolProperty> flags(50, false);
+    IndexedBoolProperty unset(flags, Bitmap());
+    unset.compact();
+    BOOST_REQUIRE(unset.encoding() == IndexedEncoding::CONSTANT);
+    BOOST_REQUIRE_EQUAL(unset.countTrue(), 0u);
+
+    // Residue names repeat for the atoms of each residue.
+    std::vector<std::string> names;
+    for (const char* name : {"ALA", "GLY", "ALA", "SER"}) {
+        names.insert(names.end(), 5, name);
+    }
+    std::vector<std::string> name_values(names);
+    IndexedStringProperty runs(name_values, Bitmap());
+    runs.compact();
+    BOOST_REQUIRE(runs.encoding() == IndexedEncoding::RUNS);
+    BOOST_REQUIRE(runs == IndexedStringProperty(names, Bitmap()));
+
+    const auto& cruns = runs;
+    BOOST_REQUIRE_EQUAL(cruns[0], "ALA");
+    BOOST_REQUIRE_EQUAL(cruns[4], "ALA");
+    BOOST_REQUIRE_EQUAL(cruns[5], "GLY");
+    BOOST_REQUIRE_EQUAL(cruns.get(19), "SER");
+    BOOST_REQUIRE_EQUAL(cruns.data()[12], "ALA");
+
+    BOOST_REQUIRE_EQUAL(cruns.at(5), "GLY");
+    BOOST_REQUIRE(runs.encoding() == IndexedEncoding::RUNS);
+    runs[5] = "PRO";
+    BOOST_REQUIRE(runs.encoding() == IndexedEncoding::DENSE);
+    BOOST_REQUIRE_EQUAL(runs.get(6), "GLY");
+
+    // Zeros of either sign are kept apart.
+    std::vector<double> zeros{0.0, 0.0, -0.0, -0.0};
+    IndexedRealProperty signed_zeros(zeros, Bitmap());
+    signed_zeros.compact();
+    BOOST_REQUIRE(signed_zeros.encoding() != IndexedEncoding::CONSTANT);
+    BOOST_REQUIRE(std::signbit(signed_zeros.get(3)));
+}
+
 BOOST_AUTO_TEST_CASE(maeIndexedBlockString)
 {
     using namespace mae;
@@ -214,6 +481,217 @@ BOOST_AUTO_TEST_CASE(maeIndexedBlockString)
     }
 }
 
+BOOST_AUTO_TEST_CASE(maeShareColumns)
+{
+    using namespace mae;
+
+    // The constructors take ownership of the values, so pass copies.
+    auto ints = [](std::vector<int> values) {
+        return std::make_shared<IndexedIntProperty>(values);
+    };
+    auto reals = [](std::vector<double> values) {
+        return std::make_shared<IndexedRealProperty>(values);
+    };
+
+    IndexedBlock previous("m_atom");
+    previous.setIntProperty("i_m_atomic_number", ints({6, 8}));
+    previous.setRealProperty("r_m_x_coord", reals({0.0, 1.5}));
+    previous.setRealProperty("r_m_y_coord", reals({0.0, 0.0}));
+
+    // Zeros of opposite sign aren't identical.
+    IndexedBlock current("m_atom");
+    current.setIntProperty("i_m_atomic_number", ints({6, 8}));
+    current.setRealProperty("r_m_x_coord", reals({0.0, 1.6}));
+    current.setRealProperty("r_m_y_coord", reals({0.0, -0.0}));
+    auto labels = std::make_shared<IndexedStringViewProperty>();
+    labels->push_back("C");
+    labels->push_back("O");
+    current.setStringViewProperty("s_m_label", labels);
+
+    auto shared = current.shareColumns(&previous);
+    BOOST_REQUIRE(*shared == current);
+    BOOST_REQUIRE(shared->getIntProperty("i_m_atomic_number") ==
+                  previous.getIntProperty("i_m_atomic_number"));
+    BOOST_REQUIRE(shared->getRealProperty("r_m_x_coord") ==
+                  current.getRealProperty("r_m_x_coord"));
+    BOOST_REQUIRE(shared->getRealProperty("r_m_y_coord") ==
+                  current.getRealProperty("r_m_y_coord"));
+    BOOST_REQUIRE(shared->getStringViewProperty("s_m_label") ==
+                  current.getStringViewProperty("s_m_label"));
+
+    auto copy = current.shareColumns(nullptr);
+    BOOST_REQUIRE(copy->getIntProperty("i_m_atomic_number") ==
+                  current.getIntProperty("i_m_atomic_number"));
+
+    // Shared columns can't be changed until a block copies them.
+    auto atomic_numbers = shared->getIntProperty("i_m_atomic_number");
+    BOOST_REQUIRE(atomic_numbers->isShared());
+    BOOST_CHECK_THROW(atomic_numbers->set(0, 7), std::logic_error);
+    BOOST_REQUIRE(labels->isShared());
+    BOOST_CHECK_THROW(labels->push_back("N"), std::logic_error);
+    BOOST_CHECK_THROW(labels->dictionaryEncode(), std::logic_error);
+    shared->unshareColumns();
+    auto own_labels = shared->getStringViewProperty("s_m_label");
+    BOOST_REQUIRE(own_labels != labels);
+    BOOST_REQUIRE(!own_labels->isShared());
+    BOOST_REQUIRE(*own_labels == *labels);
+    own_labels->push_back("N");
+    BOOST_REQUIRE_EQUAL(labels->size(), 2u);
+    atomic_numbers = shared->getIntProperty("i_m_atomic_number");
+    BOOST_REQUIRE(!atomic_numbers->isShared());
+    atomic_numbers->set(0, 7);
+    BOOST_REQUIRE_EQUAL(atomic_numbers->at(0), 7);
+    BOOST_REQUIRE_EQUAL(previous.getIntProperty("i_m_atomic_number")->at(0),
+                        6);
+
+    // A compact shared column can be read but not switched back to DENSE.
+    auto compact = previous.getRealProperty("r_m_y_coord");
+    compact->compact();
+    auto sharing = previous.shareColumns(nullptr);
+    const auto& read_only = *compact;
+    BOOST_REQUIRE_EQUAL(read_only[1], 0.0);
+    BOOST_REQUIRE_THROW((*compact)[1] = 1.0, std::logic_error);
+    BOOST_REQUIRE(compact->encoding() == IndexedEncoding::CONSTANT);
+}
+
+BOOST_AUTO_TEST_CASE(maeIndexedStringViewProperty)
+{
+    using namespace mae;
+    auto isvp = std::make_shared<IndexedStringViewProperty>();
+    isvp->push_back("Hi with space");
+    isvp->push_back_undefined();
+    isvp->push_back_escaped(R"(p \" \\this)");
+    isvp->push_back("");
+
+    BOOST_REQUIRE_EQUAL(isvp->size(), 4u);
+    BOOST_REQUIRE(isvp->hasUndefinedValues());
+    BOOST_REQUIRE_EQUAL((*isvp)[0], "Hi with space");
+    BOOST_REQUIRE(!isvp->isDefined(1));
+    BOOST_REQUIRE_THROW((*isvp)[1], std::runtime_error);
+    BOOST_REQUIRE_EQUAL(isvp->at(1, "default"), "default");
+    BOOST_REQUIRE_EQUAL(isvp->at(2), R"(p " \this)");
+    BOOST_REQUIRE_EQUAL(isvp->at(3), "");
+
+    // Either representation can be read through the IndexedBlock.
+    IndexedBlock ib("m_atom");
+    ib.setStringViewProperty("s_m_string", isvp);
+    BOOST_REQUIRE(ib.hasStringProperty("s_m_string"));
+    BOOST_REQUIRE_EQUAL(ib.size(), 4u);
+
+    // Views are written and compared without being copied.
+    IndexedBlock strings("m_atom");
+    strings.setStringProperty("s_m_string", isvp->toStringProperty());
+    BOOST_REQUIRE(strings == ib);
+    BOOST_REQUIRE_EQUAL(strings.toString(), ib.toString());
+    BOOST_REQUIRE(ib.getStringViewProperty("s_m_string") == isvp);
+
+    // The strings are copied once, in place of the views, so changes to
+    // them are kept.
+    auto isp = ib.getStringProperty("s_m_string");
+    BOOST_REQUIRE_EQUAL(isp->at(2), R"(p " \this)");
+    BOOST_REQUIRE(!isp->isDefined(1));
+    BOOST_REQUIRE(ib.getStringProperty("s_m_string") == isp);
+    isp->set(0, "changed");
+    BOOST_REQUIRE_EQUAL(ib.getStringProperty("s_m_string")->at(0), "changed");
+    BOOST_REQUIRE(!(strings == ib));
+    isp->set(0, "Hi with space");
+
+    IndexedBlock copy("m_atom");
+    copy.setStringProperty("s_m_string", isp);
+    BOOST_REQUIRE(*copy.getStringViewProperty("s_m_string") == *isvp);
+    BOOST_REQUIRE(copy == ib);
+    BOOST_REQUIRE_EQUAL(copy.toString(), ib.toString());
+
+    // Storing one representation replaces the other.
+    ib.setStringProperty("s_m_string", isp);
+    BOOST_REQUIRE(ib.getStringProperty("s_m_string") == isp);
+}
+
+BOOST_AUTO_TEST_CASE(maeDictionaryEncodedStringViews)
+{
+    using namespace mae;
+    IndexedStringViewProperty residues;
+    const std::vector<std::string> names = {"ALA", "GLY", "ALA", "SER"};
+    for (int i = 0; i < 25; ++i) {
+        for (const auto& name : names) {
+            residues.push_back(name);
+        }
+    }
+    residues.push_back_undefined();
+
+    BOOST_REQUIRE(residues.codes().empty());
+    BOOST_REQUIRE(residues.dictionaryEncode());
+    BOOST_REQUIRE(residues.isDictionaryEncoded());
+    BOOST_REQUIRE_EQUAL(residues.size(), 101u);
+    BOOST_REQUIRE_EQUAL(residues.dictionarySize(), 3u);
+    BOOST_REQUIRE_EQUAL(residues.codes().size(), 101u);
+    BOOST_REQUIRE_EQUAL(residues.code(0), residues.code(2));
+    BOOST_REQUIRE(residues.code(0) != residues.code(1));
+    BOOST_REQUIRE_EQUAL(residues.dictionaryValue(residues.code(3)), "SER");
+    BOOST_REQUIRE_EQUAL(residues[96], "ALA");
+    BOOST_REQUIRE(!residues.isDefined(100));
+    BOOST_REQUIRE_EQUAL(residues.code(100),
+                        IndexedStringViewProperty::UNDEFINED_CODE);
+    BOOST_REQUIRE_THROW(residues.push_back("CYS"), std::runtime_error);
+    BOOST_REQUIRE_EQUAL(residues.toStringProperty()->at(99), "SER");
+
+    // Distinct values gain nothing from a dictionary.
+    IndexedStringViewProperty titles;
+    titles.push_back("first title");
+    titles.push_back("second title");
+    BOOST_REQUIRE(!titles.dictionaryEncode());
+    BOOST_REQUIRE(!titles.isDictionaryEncoded());
+    BOOST_REQUIRE_EQUAL(titles[1], "second title");
+}
+
+BOOST_AUTO_TEST_CASE(maePropertyKey)
+{
+    using namespace mae;
+    const PropertyKey real_key("r_m_key_real");
+    const PropertyKey int_key("i_m_key_int");
+    const PropertyKey bool_key("b_m_key_bool");
+    const PropertyKey string_key("s_m_key_string");
+    const PropertyKey missing_key("r_m_key_missing");
+
+    Block b("dummy");
+    b.setRealProperty(real_key, 1.5);
+    b.setIntProperty("i_m_key_int", 3);
+    b.setBoolProperty(bool_key, true);
+    b.setStringProperty(string_key, "value");
+
+    BOOST_REQUIRE(b.hasRealProperty(real_key));
+    BOOST_REQUIRE_EQUAL(b.getRealProperty(real_key), 1.5);
+    BOOST_REQUIRE(b.hasIntProperty(int_key));
+    BOOST_REQUIRE_EQUAL(b.getIntProperty(int_key), 3);
+    BOOST_REQUIRE(b.hasBoolProperty(bool_key));
+    BOOST_REQUIRE(b.getBoolProperty(bool_key));
+    BOOST_REQUIRE(b.hasStringProperty(string_key));
+    BOOST_REQUIRE_EQUAL(b.getStringProperty(string_key), "value");
+    BOOST_REQUIRE_EQUAL(b.getRealProperty("r_m_key_real"), 1.5);
+
+    BOOST_REQUIRE(!b.hasRealProperty(missing_key));
+    BOOST_REQUIRE(!b.hasIntProperty(real_key));
+    BOOST_REQUIRE_THROW(b.getRealProperty(missing_key), std::out_of_range);
+
+    std::vector<int> iv = {1, 2, 3};
+    auto ib = std::make_shared<IndexedBlock>(ATOM_BLOCK);
+    ib->setIntProperty(ATOM_ATOMIC_NUM,
+                       std::make_shared<IndexedIntProperty>(iv));
+    auto ibm = std::make_shared<IndexedBlockMap>();
+    ibm->addIndexedBlock(ib->getName(), ib);
+    b.setIndexedBlockMap(ibm);
+
+    const PropertyKey atom_block(ATOM_BLOCK);
+    const PropertyKey atomic_num(ATOM_ATOMIC_NUM);
+    BOOST_REQUIRE(b.hasIndexedBlock(atom_block));
+    BOOST_REQUIRE(!b.hasIndexedBlock(missing_key));
+    auto atoms = b.getIndexedBlock(atom_block);
+    BOOST_REQUIRE(atoms->hasIntProperty(atomic_num));
+    BOOST_REQUIRE_EQUAL(atoms->getIntProperty(atomic_num)->at(2), 3);
+    BOOST_REQUIRE(atoms->getRealProperty(atomic_num) == nullptr);
+    BOOST_REQUIRE_THROW(b.getIndexedBlock(missing_key), std::out_of_range);
+}
+
 std::shared_ptr<mae::IndexedBlock> getExampleIndexedBlock()
 {
     using namespace mae;
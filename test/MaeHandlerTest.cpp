@@ -0,0 +1,234 @@
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+#include "MaeHandler.hpp"
+#include "MaeParser.hpp"
+#include "Reader.hpp"
+
+using namespace schrodinger::mae;
+
+namespace
+{
+const boost::filesystem::path test_samples_path(TEST_SAMPLES_PATH);
+const std::string uncompressed_sample =
+    (test_samples_path / "test.mae").string();
+
+/**
+ * Record every event as a line of text.
+ */
+class RecordingHandler : public MaeHandler
+{
+  public:
+    std::vector<std::string> events;
+
+    void onOuterBlockBegin(boost::string_view name) override
+    {
+        events.push_back("outer " + name.to_string());
+    }
+
+    void onBlockBegin(boost::string_view name) override
+    {
+        events.push_back("block " + name.to_string());
+    }
+
+    void onProperty(InternedName name, const MaeValue& value) override
+    {
+        events.push_back(name.str() + "=" + value.toString());
+    }
+
+    bool onIndexedBlockBegin(boost::string_view name, size_t rows,
+                             const std::vector<InternedName>& columns) override
+    {
+        events.push_back("indexed " + name.to_string() + " " +
+                         std::to_string(rows) + " " +
+                         std::to_string(columns.size()));
+        return name != "m_skipped";
+    }
+
+    void onIndexedRow(size_t row, const std::vector<MaeValue>& values) override
+    {
+        std::string event = "row " + std::to_string(row);
+        for (const auto& value : values) {
+            event += value.isDefined() ? " " + value.toString() : " <>";
+        }
+        events.push_back(event);
+    }
+
+    void onIndexedBlockEnd(boost::string_view name) override
+    {
+        events.push_back("end indexed " + name.to_string());
+    }
+
+    void onBlockEnd(boost::string_view name) override
+    {
+        events.push_back("end " + name.to_string());
+    }
+};
+
+/**
+ * Sum the atom coordinates of each f_m_ct block.
+ */
+class CoordinateSumHandler : public MaeHandler
+{
+    int m_x_column{-1};
+
+  public:
+    size_t structures{0};
+    size_t atoms{0};
+    double x_sum{0.0};
+    std::vector<std::string> titles;
+
+    void onOuterBlockBegin(boost::string_view name) override
+    {
+        structures += name == CT_BLOCK;
+    }
+
+    void onProperty(InternedName name, const MaeValue& value) override
+    {
+        if (name.str() == CT_TITLE) {
+            titles.push_back(value.toString());
+        }
+    }
+
+    bool onIndexedBlockBegin(boost::string_view name, size_t /*rows*/,
+                             const std::vector<InternedName>& columns) override
+    {
+        m_x_column = -1;
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (columns[i].str() == ATOM_X_COORD) {
+                m_x_column = static_cast<int>(i);
+            }
+        }
+        return name == ATOM_BLOCK;
+    }
+
+    void onIndexedRow(size_t /*row*/,
+                      const std::vector<MaeValue>& values) override
+    {
+        ++atoms;
+        if (m_x_column >= 0 && values[m_x_column].isDefined()) {
+            x_sum += values[m_x_column].toReal();
+        }
+    }
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(MaeHandlerSuite)
+
+BOOST_AUTO_TEST_CASE(MaeValueConversions)
+{
+    BOOST_REQUIRE_EQUAL(MaeValue("1").toBool(), true);
+    BOOST_REQUIRE_THROW(MaeValue("2").toBool(), std::out_of_range);
+    BOOST_REQUIRE_EQUAL(MaeValue("-42").toInt(), -42);
+    BOOST_REQUIRE_EQUAL(MaeValue("1.5e2").toReal(), 150.0);
+    BOOST_REQUIRE_THROW(MaeValue("x").toReal(), std::invalid_argument);
+    BOOST_REQUIRE(!MaeValue("<>").isDefined());
+
+    const MaeValue quoted("\"a \\\"b\\\\\"");
+    BOOST_REQUIRE_EQUAL(quoted.view(), "a \\\"b\\\\");
+    BOOST_REQUIRE_EQUAL(quoted.toString(), "a \"b\\");
+    BOOST_REQUIRE_EQUAL(MaeValue("a\\b").toString(), "a\\b");
+}
+
+BOOST_AUTO_TEST_CASE(EventOrder)
+{
+    const std::string mae = "{\n"
+                            "  s_m_m2io_version\n"
+                            "  :::\n"
+                            "  2.0.0\n"
+                            "}\n"
+                            "f_m_ct {\n"
+                            "  s_m_title\n"
+                            "  i_m_count\n"
+                            "  :::\n"
+                            "  \"a \\\"quoted\\\" title\"\n"
+                            "  3\n"
+                            "  m_atom[2] {\n"
+                            "    r_m_x_coord\n"
+                            "    s_m_name\n"
+                            "    :::\n"
+                            "    1 1.5 \"long atom name\" # comment #\n"
+                            "    2 <>\n"
+                            "      N\n"
+                            "    :::\n"
+                            "  }\n"
+                            "  m_skipped[1] {\n"
+                            "    i_m_value\n"
+                            "    :::\n"
+                            "    1 7\n"
+                            "    :::\n"
+                            "  }\n"
+                            "  m_nested {\n"
+                            "    b_m_flag\n"
+                            "    :::\n"
+                            "    1\n"
+                            "  }\n"
+                            "}\n";
+    const std::vector<std::string> expected = {
+        "outer ",
+        "s_m_m2io_version=2.0.0",
+        "end ",
+        "outer f_m_ct",
+        "s_m_title=a \"quoted\" title",
+        "i_m_count=3",
+        "indexed m_atom 2 2",
+        "row 0 1.5 long atom name",
+        "row 1 <> N",
+        "end indexed m_atom",
+        "indexed m_skipped 1 1",
+        "end indexed m_skipped",
+        "block m_nested",
+        "b_m_flag=1",
+        "end m_nested",
+        "end f_m_ct",
+    };
+
+    // Tiny buffers force reloads in the middle of rows and tokens.
+    for (size_t buffer_size : {4, 7, 16, 4096}) {
+        auto stream = std::make_shared<std::stringstream>(mae);
+        Reader r(stream, buffer_size);
+        RecordingHandler handler;
+        while (r.next(handler)) {
+        }
+        BOOST_REQUIRE(handler.events == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AggregateWithoutBlocks)
+{
+    Reader block_reader(uncompressed_sample);
+    size_t structures = 0;
+    size_t atoms = 0;
+    double x_sum = 0.0;
+    std::vector<std::string> titles;
+    std::shared_ptr<Block> b;
+    while ((b = block_reader.next(CT_BLOCK)) != nullptr) {
+        ++structures;
+        titles.push_back(b->getStringProperty(CT_TITLE));
+        auto atom_block = b->getIndexedBlock(ATOM_BLOCK);
+        auto x = atom_block->getRealProperty(ATOM_X_COORD);
+        atoms += atom_block->size();
+        for (size_t i = 0; i < x->size(); ++i) {
+            x_sum += (*x)[i];
+        }
+    }
+
+    Reader r(uncompressed_sample);
+    CoordinateSumHandler handler;
+    while (r.next(handler)) {
+    }
+    BOOST_REQUIRE_EQUAL(handler.structures, structures);
+    BOOST_REQUIRE_EQUAL(handler.atoms, atoms);
+    BOOST_REQUIRE(handler.titles == titles);
+    BOOST_REQUIRE_CLOSE(handler.x_sum, x_sum, 1e-9);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
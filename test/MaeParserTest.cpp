@@ -26,6 +26,22 @@ static std::string get_string(IndexedBlockBuffer& indexed_block_buffer,
 
 BOOST_AUTO_TEST_SUITE(MaeParserSuite)
 
+BOOST_AUTO_TEST_CASE(StringBuffer)
+{
+    // The whole string is loaded, with the '\0' terminator after it.
+    Buffer b(std::string("i_m_count\n:::\n42"));
+    BOOST_REQUIRE_EQUAL(*b.end, '\0');
+    BOOST_REQUIRE(b.load());
+    BOOST_REQUIRE(interned_property_key(b) == "i_m_count");
+    whitespace(b);
+    BOOST_REQUIRE(!interned_property_key(b));
+    b.current += 3;
+    whitespace(b);
+    BOOST_REQUIRE_EQUAL(parse_value<int>(b), 42);
+    BOOST_REQUIRE(b.current == b.end);
+    BOOST_REQUIRE(!b.load());
+}
+
 BOOST_AUTO_TEST_CASE(OuterBlockBeginning)
 {
     {
@@ -147,6 +163,28 @@ BOOST_AUTO_TEST_CASE(BlockBeginning)
     }
 }
 
+BOOST_AUTO_TEST_CASE(Properties)
+{
+    const std::string header = "i_m_one\ns_m_two :::";
+    {
+        auto ss = std::make_shared<std::stringstream>(header);
+        MaeParser mp(ss);
+        std::vector<std::shared_ptr<std::string>> names;
+        mp.properties(&names);
+        BOOST_REQUIRE_EQUAL(names.size(), 2u);
+        BOOST_REQUIRE_EQUAL(*names[0], "i_m_one");
+        BOOST_REQUIRE_EQUAL(*names[1], "s_m_two");
+    }
+    {
+        auto ss = std::make_shared<std::stringstream>(header);
+        MaeParser mp(ss);
+        std::vector<InternedName> names;
+        mp.properties(&names);
+        BOOST_REQUIRE_EQUAL(names.size(), 2u);
+        BOOST_REQUIRE(names[1] == "s_m_two");
+    }
+}
+
 BOOST_AUTO_TEST_CASE(BlockBeginningErrors)
 {
     {
@@ -356,6 +394,53 @@ BOOST_AUTO_TEST_CASE(PropertyList)
     }
 }
 
+BOOST_AUTO_TEST_CASE(IndexedHeaders)
+{
+    const auto atom = NameTable::intern("m_atom");
+    const std::vector<InternedName> names = {NameTable::intern("r_m_x"),
+                                             NameTable::intern("s_m_name")};
+    const std::string header = "r_m_x\n  s_m_name\n  :::\n  1 2.0 N\n";
+    IndexedHeaderCache cache;
+    for (size_t hits : {0u, 1u, 2u}) {
+        std::stringstream ss(header);
+        Buffer b(ss);
+        b.load();
+        BOOST_REQUIRE(cache.read(atom, b) == names);
+        BOOST_REQUIRE_EQUAL(cache.hits(), hits);
+        BOOST_REQUIRE_EQUAL(b.line_number, 3u);
+        BOOST_REQUIRE_EQUAL(*b.current, '\n');
+    }
+
+    // A different header of the same block doesn't evict the first.
+    {
+        std::stringstream ss("r_m_x :::\n");
+        Buffer b(ss);
+        b.load();
+        BOOST_REQUIRE_EQUAL(cache.read(atom, b).size(), 1u);
+        std::stringstream ss2(header);
+        Buffer b2(ss2);
+        b2.load();
+        BOOST_REQUIRE(cache.read(atom, b2) == names);
+        BOOST_REQUIRE_EQUAL(cache.hits(), 3u);
+    }
+
+    // Headers with comments, or split across buffer loads, aren't cached.
+    IndexedHeaderCache uncached;
+    for (int i = 0; i < 2; ++i) {
+        std::stringstream ss("r_m_x # : ::: # s_m_name :::\n");
+        Buffer b(ss);
+        b.load();
+        BOOST_REQUIRE(uncached.read(atom, b) == names);
+
+        std::stringstream split_ss(header);
+        Buffer split(split_ss, 8u);
+        split.load();
+        BOOST_REQUIRE(uncached.read(atom, split) == names);
+        BOOST_REQUIRE_EQUAL(split.line_number, 3u);
+    }
+    BOOST_REQUIRE_EQUAL(uncached.hits(), 0u);
+}
+
 BOOST_AUTO_TEST_CASE(PropertyErrors)
 {
     {
@@ -617,6 +702,22 @@ BOOST_AUTO_TEST_CASE(String)
         std::string s = parse_value<std::string>(b);
         BOOST_REQUIRE_EQUAL(s, "abcdef");
     }
+    {
+        // An escape that ends a buffer escapes the first character loaded.
+        std::stringstream ss(R"( "ab\"c" d)");
+        Buffer b(ss, 5);
+        whitespace(b);
+        std::string s = parse_value<std::string>(b);
+        BOOST_REQUIRE_EQUAL(s, "ab\"c");
+    }
+    {
+        // A '\0' within the data isn't mistaken for the end of the buffer.
+        std::stringstream ss(std::string("a\0b c", 5));
+        Buffer b(ss);
+        whitespace(b);
+        std::string s = parse_value<std::string>(b);
+        BOOST_REQUIRE_EQUAL(s, std::string("a\0b", 3));
+    }
 }
 
 BOOST_AUTO_TEST_CASE(StringErrors)
@@ -1035,4 +1136,191 @@ BOOST_AUTO_TEST_CASE(TestOneCharValues)
     BOOST_REQUIRE_EQUAL(z, std::string("40"));
 }
 
+BOOST_AUTO_TEST_CASE(TestRowIterator)
+{
+    std::stringstream ss(" 1 1.5 \"first row\" 1 "
+                         " 2 <> abcdefghij 0 "
+                         " 3 -2 \"\" <>\n");
+    Buffer b(ss, 5);
+    IndexedBlockBuffer ibb("m_test", 3);
+    ibb.addPropertyName("r_m_x");
+    ibb.addPropertyName("s_m_name");
+    ibb.addPropertyName("b_m_flag");
+    ibb.parse(b);
+    BOOST_REQUIRE_EQUAL(ibb.getPropertyNames().size(), 3u);
+
+    std::vector<std::string> values;
+    size_t rows = 0;
+    for (const auto& row : ibb) {
+        BOOST_REQUIRE_EQUAL(row.index(), rows++);
+        BOOST_REQUIRE_EQUAL(row.size(), 3u);
+        // Read the columns out of order.
+        values.push_back(row[2].isDefined() ? row[2].toString() : "<>");
+        values.push_back(row[0].isDefined() ? row[0].toString() : "<>");
+        values.push_back(row[1].toString());
+    }
+    BOOST_REQUIRE_EQUAL(rows, 3u);
+    const std::vector<std::string> expected = {
+        "1", "1.5", "first row", "0", "<>", "abcdefghij", "<>", "-2", ""};
+    BOOST_REQUIRE(values == expected);
+
+    auto row = ibb.begin();
+    BOOST_REQUIRE_EQUAL(row->operator[](0).toReal(), 1.5);
+    BOOST_REQUIRE_EQUAL((++row)->operator[](2).toBool(), false);
+    BOOST_REQUIRE(++row != ibb.end());
+    BOOST_REQUIRE(++row == ibb.end());
+}
+
+BOOST_AUTO_TEST_CASE(TestMaterializeSlabs)
+{
+    // Enough rows for several slabs, spread over many small buffers.
+    const size_t rows = 5000;
+    std::string tokens;
+    for (size_t i = 0; i < rows; ++i) {
+        tokens += " " + std::to_string(i + 1) + " " + std::to_string(i) +
+                  (i % 7 == 0 ? " <>" : " \"n " + std::to_string(i) + "\"") +
+                  (i % 2 == 0 ? " 1.5" : " -2") + "\n";
+    }
+    for (bool string_views : {false, true}) {
+        std::stringstream ss(tokens);
+        Buffer b(ss, 64);
+        IndexedBlockOptions options;
+        options.string_views = string_views;
+        IndexedBlockBuffer ibb(NameTable::intern("m_test"), rows, options);
+        ibb.addPropertyName("i_m_i");
+        ibb.addPropertyName("s_m_s");
+        ibb.addPropertyName("r_m_r");
+        ibb.parse(b);
+
+        const auto block = ibb.getIndexedBlock(nullptr);
+        const auto ints = block->getIntProperty("i_m_i");
+        const auto reals = block->getRealProperty("r_m_r");
+        BOOST_REQUIRE_EQUAL(ints->size(), rows);
+        for (size_t i = 0; i < rows; ++i) {
+            BOOST_REQUIRE_EQUAL((*ints)[i], static_cast<int>(i));
+            BOOST_REQUIRE_EQUAL((*reals)[i], i % 2 == 0 ? 1.5 : -2.0);
+            const std::string name = "n " + std::to_string(i);
+            if (string_views) {
+                const auto strings = block->getStringViewProperty("s_m_s");
+                BOOST_REQUIRE_EQUAL(strings->isDefined(i), i % 7 != 0);
+                if (i % 7 != 0) {
+                    BOOST_REQUIRE_EQUAL((*strings)[i], name);
+                }
+            } else {
+                const auto strings = block->getStringProperty("s_m_s");
+                BOOST_REQUIRE_EQUAL(strings->isDefined(i), i % 7 != 0);
+                if (i % 7 != 0) {
+                    BOOST_REQUIRE_EQUAL((*strings)[i], name);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestParallelMaterialize)
+{
+    // Enough values to be split across threads.
+    const size_t rows = 20000;
+    std::string tokens;
+    for (size_t i = 0; i < rows; ++i) {
+        tokens += " " + std::to_string(i + 1) + " " + std::to_string(i) +
+                  (i % 7 == 0 ? " <>" : " \"n " + std::to_string(i) + "\"") +
+                  " 0." + std::to_string(i) + (i % 3 == 0 ? " 1" : " 0");
+    }
+
+    auto materialize = [&](const std::string& tokens, size_t threads,
+                           bool dictionary_encoding) {
+        std::stringstream ss(tokens);
+        Buffer b(ss, 4096);
+        IndexedBlockOptions options;
+        options.dictionary_encoding = dictionary_encoding;
+        options.materialization_threads = threads;
+        IndexedBlockBuffer ibb(NameTable::intern("m_test"), rows, options);
+        for (const char* name : {"i_m_i", "s_m_s", "r_m_r", "b_m_b"}) {
+            ibb.addPropertyName(name);
+        }
+        ibb.parse(b);
+        return ibb.getIndexedBlock(nullptr);
+    };
+
+    for (bool dictionary_encoding : {false, true}) {
+        const auto serial = materialize(tokens, 1, dictionary_encoding);
+        const auto parallel = materialize(tokens, 3, dictionary_encoding);
+        BOOST_REQUIRE(*parallel == *serial);
+        BOOST_REQUIRE_EQUAL(parallel->getIntProperty("i_m_i")->at(rows - 1),
+                            static_cast<int>(rows - 1));
+    }
+
+    // Errors on worker threads reach the caller.
+    const auto bad_tokens = tokens.substr(0, tokens.size() - 1) + "2";
+    BOOST_REQUIRE_THROW(materialize(bad_tokens, 4, false), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(TestParallelTokenization)
+{
+    // Enough values to be split across threads.
+    const size_t rows = 25000;
+    size_t loaded = 0;
+    auto tokenize = [rows, &loaded](const std::string& body, size_t threads,
+                           std::vector<std::string>& tokens,
+                           const std::string& closing = "\n  :::\n}\n") {
+        std::stringstream ss(body + closing);
+        Buffer b(ss, 256);
+        BOOST_REQUIRE(b.load());
+        IndexedBlockOptions options;
+        options.tokenization_threads = threads;
+        IndexedBlockBuffer ibb(NameTable::intern("m_test"), rows, options);
+        ibb.addPropertyName("i_m_i");
+        ibb.addPropertyName("s_m_s");
+        ibb.parse(b);
+
+        tokens.clear();
+        for (size_t ix = 0; ix < rows * 3; ++ix) {
+            tokens.push_back(get_string(ibb, ix));
+        }
+        // The buffer is left at the closing ':::'.
+        for (int i = 0; i < 3; ++i) {
+            BOOST_REQUIRE(b.load() && *b.current == ':');
+            ++b.current;
+        }
+        loaded = b.size();
+        return b.line_number;
+    };
+
+    std::vector<std::string> bodies(3);
+    for (size_t i = 0; i < rows; ++i) {
+        const std::string row = "\n  " + std::to_string(i + 1) + " ";
+        const std::string value = std::to_string(i);
+        // Plain, quoted and commented values.
+        bodies[0] += row + value + " \"a \\\" " + value + "\"";
+        bodies[1] += row + value + (i % 100 == 0 ? " # c \n c # " : " ") +
+                     "<>";
+        // Quoted strings spanning lines make the chunks inconsistent.
+        bodies[2] += row + value + " \"a\n" +
+                     (i % 1000 == 0 ? " :::" : "") + "\nb\"";
+    }
+
+    for (const auto& body : bodies) {
+        std::vector<std::string> serial;
+        std::vector<std::string> parallel;
+        const size_t serial_lines = tokenize(body, 1, serial);
+        for (size_t threads : {2, 3, 8}) {
+            BOOST_REQUIRE_EQUAL(tokenize(body, threads, parallel),
+                                serial_lines);
+            BOOST_REQUIRE(parallel == serial);
+        }
+    }
+
+    // A ':::' on the line of the last row still ends the body, and the
+    // rest of the file isn't read looking for it.
+    const std::string closing = " :::\n}\n" + std::string(1 << 20, '\n');
+    std::vector<std::string> serial;
+    std::vector<std::string> parallel;
+    const size_t serial_lines = tokenize(bodies[0], 1, serial, closing);
+    BOOST_REQUIRE_EQUAL(tokenize(bodies[0], 3, parallel, closing),
+                        serial_lines);
+    BOOST_REQUIRE(parallel == serial);
+    BOOST_REQUIRE_LT(loaded, bodies[0].size() + closing.size() / 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
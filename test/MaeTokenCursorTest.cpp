@@ -0,0 +1,183 @@
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+#include "MaeParser.hpp"
+#include "MaeTokenCursor.hpp"
+#include "Reader.hpp"
+
+using namespace schrodinger::mae;
+
+namespace
+{
+const boost::filesystem::path test_samples_path(TEST_SAMPLES_PATH);
+const std::string uncompressed_sample =
+    (test_samples_path / "test.mae").string();
+
+std::string describe(const MaeToken& token)
+{
+    const std::string text(token.text.data(), token.text.size());
+    const std::string depth = std::to_string(token.depth);
+    switch (token.type) {
+    case MaeTokenType::BLOCK_BEGIN:
+        return "begin " + depth + " " + text +
+               (token.indexed ? "[" + std::to_string(token.row) + "]" : "");
+    case MaeTokenType::KEY:
+        return "key " + text;
+    case MaeTokenType::SEPARATOR:
+        return "sep";
+    case MaeTokenType::VALUE:
+        return "value " + token.name.str() + " " +
+               std::to_string(token.row) + " " + token.value().toString();
+    case MaeTokenType::BLOCK_END:
+        return "end " + depth + " " + text;
+    case MaeTokenType::END:
+        return "eof";
+    }
+    return "";
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(MaeTokenCursorSuite)
+
+BOOST_AUTO_TEST_CASE(TokenOrder)
+{
+    const std::string mae = "{\n"
+                            "  s_m_m2io_version\n"
+                            "  :::\n"
+                            "  2.0.0\n"
+                            "}\n"
+                            "f_m_ct {\n"
+                            "  s_m_title\n"
+                            "  :::\n"
+                            "  \"a \\\"quoted\\\" title\" # comment #\n"
+                            "  m_atom[2] {\n"
+                            "    r_m_x_coord\n"
+                            "    s_m_name\n"
+                            "    :::\n"
+                            "    1 1.5 \"long atom name\"\n"
+                            "    2 <>\n"
+                            "      N\n"
+                            "    :::\n"
+                            "  }\n"
+                            "  m_nested {\n"
+                            "    b_m_flag\n"
+                            "    :::\n"
+                            "    1\n"
+                            "  }\n"
+                            "}\n";
+    const std::vector<std::string> expected = {
+        "begin 0 ",
+        "key s_m_m2io_version",
+        "sep",
+        "value s_m_m2io_version 0 2.0.0",
+        "end 0 ",
+        "begin 0 f_m_ct",
+        "key s_m_title",
+        "sep",
+        "value s_m_title 0 a \"quoted\" title",
+        "begin 1 m_atom[2]",
+        "key r_m_x_coord",
+        "key s_m_name",
+        "sep",
+        "value r_m_x_coord 0 1.5",
+        "value s_m_name 0 long atom name",
+        "value r_m_x_coord 1 <>",
+        "value s_m_name 1 N",
+        "sep",
+        "end 1 m_atom",
+        "begin 1 m_nested",
+        "key b_m_flag",
+        "sep",
+        "value b_m_flag 0 1",
+        "end 1 m_nested",
+        "end 0 f_m_ct",
+        "eof",
+        "eof",
+    };
+
+    // Tiny buffers force reloads in the middle of tokens.
+    for (size_t buffer_size : {4, 7, 16, 4096}) {
+        auto stream = std::make_shared<std::stringstream>(mae);
+        MaeTokenCursor cursor(stream, buffer_size);
+        std::vector<std::string> tokens;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            tokens.push_back(describe(cursor.next()));
+        }
+        BOOST_REQUIRE(tokens == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ExtractValues)
+{
+    const std::string energy_name = "r_mmod_Potential_Energy-OPLS-2005";
+    std::vector<std::string> titles;
+    std::vector<double> energies;
+    {
+        Reader r(uncompressed_sample);
+        std::shared_ptr<Block> b;
+        while ((b = r.next(CT_BLOCK)) != nullptr) {
+            titles.push_back(b->getStringProperty(CT_TITLE));
+            energies.push_back(b->getRealProperty(energy_name));
+        }
+    }
+
+    // Read two properties of each f_m_ct block and skip everything else.
+    const auto ct_block = NameTable::intern(CT_BLOCK);
+    const auto title = NameTable::intern(CT_TITLE);
+    const auto energy = NameTable::intern(energy_name);
+    std::vector<std::string> cursor_titles;
+    std::vector<double> cursor_energies;
+    auto stream = std::make_shared<std::ifstream>(uncompressed_sample);
+    MaeTokenCursor cursor(stream, 512);
+    for (auto* token = &cursor.next(); token->type != MaeTokenType::END;
+         token = &cursor.next()) {
+        if (token->type != MaeTokenType::BLOCK_BEGIN) {
+            continue;
+        }
+        if (token->name != ct_block) {
+            cursor.skipBlock();
+            continue;
+        }
+        while ((token = &cursor.next())->type != MaeTokenType::BLOCK_BEGIN &&
+               token->type != MaeTokenType::BLOCK_END) {
+            if (token->type != MaeTokenType::VALUE) {
+                continue;
+            } else if (token->name == title) {
+                cursor_titles.push_back(token->value().toString());
+            } else if (token->name == energy) {
+                cursor_energies.push_back(token->value().toReal());
+            }
+        }
+        if (token->type == MaeTokenType::BLOCK_BEGIN) {
+            cursor.skipBlock(); // the first nested block
+            cursor.skipBlock(); // the rest of the f_m_ct block
+        }
+    }
+    BOOST_REQUIRE(cursor_titles == titles);
+    BOOST_REQUIRE(cursor_energies == energies);
+}
+
+BOOST_AUTO_TEST_CASE(BadInput)
+{
+    for (const std::string mae : {"x_m_ct {\n}\n", "f_m_ct {\n s_m_title\n",
+                                  "f_m_ct {\n :::\n m_atom[1] {\n"
+                                  " i_m_x\n :::\n 1 2\n }\n}\n"}) {
+        auto stream = std::make_shared<std::stringstream>(mae);
+        MaeTokenCursor cursor(stream);
+        auto read_all = [&cursor]() {
+            while (cursor.next().type != MaeTokenType::END) {
+            }
+        };
+        BOOST_REQUIRE_THROW(read_all(), read_exception);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
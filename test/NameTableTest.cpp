@@ -0,0 +1,107 @@
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "MaeBlock.hpp"
+#include "MaeParser.hpp"
+#include "NameTable.hpp"
+
+using namespace schrodinger::mae;
+
+BOOST_AUTO_TEST_SUITE(NameTableSuite)
+
+BOOST_AUTO_TEST_CASE(InternIsIdempotent)
+{
+    const std::string name("r_nametable_x_coord");
+    auto a = NameTable::intern(name);
+    auto b = NameTable::intern(name.data(), name.size());
+    BOOST_REQUIRE(a);
+    BOOST_REQUIRE(a == b);
+    BOOST_REQUIRE_EQUAL(&a.str(), &b.str());
+    BOOST_REQUIRE_EQUAL(a.str(), name);
+    BOOST_REQUIRE(a == name);
+}
+
+BOOST_AUTO_TEST_CASE(FindDoesNotInsert)
+{
+    const auto size = NameTable::size();
+    BOOST_REQUIRE(!NameTable::find("s_nametable_never_interned"));
+    BOOST_REQUIRE_EQUAL(NameTable::size(), size);
+
+    auto name = NameTable::intern("s_nametable_interned");
+    BOOST_REQUIRE(NameTable::find("s_nametable_interned") == name);
+    BOOST_REQUIRE_EQUAL(NameTable::size(), size + 1);
+}
+
+BOOST_AUTO_TEST_CASE(OrderingFollowsValues)
+{
+    // Intern in reverse order so pointer order can't accidentally agree.
+    auto b = NameTable::intern("i_nametable_b");
+    auto a = NameTable::intern("i_nametable_a");
+    BOOST_REQUIRE(a < b);
+    BOOST_REQUIRE(!(b < a));
+    BOOST_REQUIRE(!(a < a));
+
+    // Null names order first, so they are safe map keys.
+    const InternedName null;
+    BOOST_REQUIRE(null < a);
+    BOOST_REQUIRE(!(a < null));
+    BOOST_REQUIRE(!(null < null));
+    std::map<InternedName, int> keyed = {{a, 1}, {null, 0}, {b, 2}};
+    BOOST_REQUIRE(!keyed.begin()->first);
+    BOOST_REQUIRE(keyed.rbegin()->first == b);
+}
+
+BOOST_AUTO_TEST_CASE(SharedAcrossThreads)
+{
+    const std::string name("b_nametable_threaded");
+    std::vector<InternedName> names(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < names.size(); ++i) {
+        threads.emplace_back(
+            [&names, &name, i]() { names[i] = NameTable::intern(name); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (const auto& n : names) {
+        BOOST_REQUIRE(n == names[0]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BlocksShareNames)
+{
+    Block b1("f_m_ct");
+    Block b2("f_m_ct");
+    b1.setRealProperty("r_nametable_score", 1.0);
+    b2.setRealProperty("r_nametable_score", 2.0);
+
+    const auto& p1 = b1.getInternedProperties<double>();
+    const auto& p2 = b2.getInternedProperties<double>();
+    BOOST_REQUIRE_EQUAL(&p1.begin()->first.str(), &p2.begin()->first.str());
+    BOOST_REQUIRE_EQUAL(&b1.getName(), &b2.getName());
+}
+
+BOOST_AUTO_TEST_CASE(ParsedKeysAreInterned)
+{
+    std::stringstream ss("r_nametable_parsed :::");
+    schrodinger::Buffer b(ss);
+    b.load();
+    const auto name = interned_property_key(b);
+    BOOST_REQUIRE(name);
+    BOOST_REQUIRE(name == NameTable::find("r_nametable_parsed"));
+
+    // The old interface still returns a copy of the name.
+    std::stringstream ss2("r_nametable_parsed :::");
+    schrodinger::Buffer b2(ss2);
+    b2.load();
+    const auto copy = property_key(b2);
+    BOOST_REQUIRE(copy != nullptr);
+    BOOST_REQUIRE_EQUAL(*copy, "r_nametable_parsed");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
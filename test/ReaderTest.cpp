@@ -1,6 +1,7 @@
 #include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
@@ -319,6 +320,253 @@ BOOST_AUTO_TEST_CASE(QuotedStringTest)
     fclose(f);
 }
 
+BOOST_AUTO_TEST_CASE(StringViewReader)
+{
+    Reader reference(uncompressed_sample);
+    Reader buffered(uncompressed_sample);
+    buffered.setStringViews(true);
+
+    auto direct_parser = std::make_shared<DirectMaeParser>(
+        std::make_shared<std::ifstream>(uncompressed_sample));
+    direct_parser->setStringViews(true);
+    Reader direct(direct_parser);
+    Reader direct_reference(std::make_shared<DirectMaeParser>(
+        std::make_shared<std::ifstream>(uncompressed_sample)));
+
+    std::shared_ptr<Block> b;
+    while ((b = reference.next(CT_BLOCK)) != nullptr) {
+        auto bb = buffered.next(CT_BLOCK);
+        BOOST_REQUIRE(*bb == *b);
+        auto db = direct.next(CT_BLOCK);
+        BOOST_REQUIRE(*db == *direct_reference.next(CT_BLOCK));
+
+        for (const auto& block : {bb, db}) {
+            auto atom_block = block->getIndexedBlock(ATOM_BLOCK);
+            auto names = atom_block->getStringViewProperty("s_m_atom_name");
+            BOOST_REQUIRE(names != nullptr);
+            auto expected = b->getIndexedBlock(ATOM_BLOCK)
+                                ->getStringProperty("s_m_atom_name");
+            BOOST_REQUIRE_EQUAL(names->size(), expected->size());
+            for (size_t i = 0; i < names->size(); ++i) {
+                BOOST_REQUIRE_EQUAL(names->isDefined(i),
+                                    expected->isDefined(i));
+                if (names->isDefined(i)) {
+                    BOOST_REQUIRE_EQUAL(names->at(i), expected->at(i));
+                }
+            }
+        }
+    }
+
+    Reader r(uncompressed_sample);
+    r.setStringViews(true);
+    auto atom_block = r.next(CT_BLOCK)->getIndexedBlock(ATOM_BLOCK);
+    auto atom_names = atom_block->getStringViewProperty("s_m_atom_name");
+    BOOST_REQUIRE_EQUAL(atom_names->at(0), R"(Does p " \this work)");
+    auto pdb_res = atom_block->getStringViewProperty("s_m_pdb_residue_name");
+    BOOST_REQUIRE_EQUAL(pdb_res->at(0), "UNK ");
+}
+
+BOOST_AUTO_TEST_CASE(DictionaryEncodingReader)
+{
+    Reader reference(uncompressed_sample);
+    Reader r(uncompressed_sample);
+    r.setDictionaryEncoding(true);
+
+    std::shared_ptr<Block> b;
+    size_t encoded = 0;
+    while ((b = r.next(CT_BLOCK)) != nullptr) {
+        BOOST_REQUIRE(*b == *reference.next(CT_BLOCK));
+
+        auto atom_block = b->getIndexedBlock(ATOM_BLOCK);
+        auto residues =
+            atom_block->getStringViewProperty("s_m_pdb_residue_name");
+        BOOST_REQUIRE(residues != nullptr);
+        if (!residues->isDictionaryEncoded()) {
+            continue;
+        }
+        ++encoded;
+        for (size_t i = 0; i < residues->size(); ++i) {
+            for (size_t j = 0; j < residues->size(); ++j) {
+                BOOST_REQUIRE_EQUAL(residues->code(i) == residues->code(j),
+                                    residues->at(i, "<>") ==
+                                        residues->at(j, "<>"));
+            }
+        }
+    }
+    BOOST_REQUIRE(encoded > 0);
+}
+
+BOOST_AUTO_TEST_CASE(CompactColumnsReader)
+{
+    const std::string mae = "f_m_ct {\n"
+                            "  s_m_title\n"
+                            "  :::\n"
+                            "  title\n"
+                            "  m_atom[3] {\n"
+                            "    b_m_flag\n"
+                            "    i_m_atomic_number\n"
+                            "    i_m_color\n"
+                            "    :::\n"
+                            "    1 1 6 4\n"
+                            "    2 <> 8 4\n"
+                            "    3 0 1 4\n"
+                            "    :::\n"
+                            "  }\n"
+                            "}\n";
+
+    for (bool direct : {false, true}) {
+        auto reference_stream = std::make_shared<std::stringstream>(mae);
+        auto stream = std::make_shared<std::stringstream>(mae);
+        std::shared_ptr<MaeParser> reference_parser;
+        std::shared_ptr<MaeParser> parser;
+        if (direct) {
+            reference_parser = std::make_shared<DirectMaeParser>(
+                reference_stream);
+            parser = std::make_shared<DirectMaeParser>(stream);
+        } else {
+            reference_parser = std::make_shared<MaeParser>(reference_stream);
+            parser = std::make_shared<MaeParser>(stream);
+        }
+        parser->setCompactColumns(true);
+        auto reference = Reader(reference_parser).next(CT_BLOCK);
+        auto b = Reader(parser).next(CT_BLOCK);
+        BOOST_REQUIRE(*b == *reference);
+
+        auto atoms = b->getIndexedBlock(ATOM_BLOCK);
+        std::shared_ptr<const IndexedBoolProperty> flags =
+            atoms->getBoolProperty("b_m_flag");
+        BOOST_REQUIRE(flags->encoding() == IndexedEncoding::BITS);
+        BOOST_REQUIRE_EQUAL((*flags)[0], static_cast<BoolProperty>(true));
+        BOOST_REQUIRE(!flags->isDefined(1));
+        BOOST_REQUIRE_EQUAL(flags->countTrue(), 1u);
+        std::shared_ptr<const IndexedIntProperty> colors =
+            atoms->getIntProperty("i_m_color");
+        BOOST_REQUIRE(colors->encoding() == IndexedEncoding::CONSTANT);
+        BOOST_REQUIRE_EQUAL((*colors)[2], 4);
+        BOOST_REQUIRE_EQUAL(atoms->toString(),
+                            reference->getIndexedBlock(ATOM_BLOCK)->toString());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SinglePrecisionReader)
+{
+    Reader reference_reader(uncompressed_sample);
+    Reader r(uncompressed_sample);
+    r.setCompactColumns(true);
+    r.setSinglePrecisionReals(true);
+
+    std::shared_ptr<Block> reference;
+    while ((reference = reference_reader.next(CT_BLOCK)) != nullptr) {
+        auto b = r.next(CT_BLOCK);
+        BOOST_REQUIRE(b != nullptr);
+        std::shared_ptr<const IndexedBlock> atoms =
+            b->getIndexedBlock(ATOM_BLOCK);
+        auto reference_atoms = reference->getIndexedBlock(ATOM_BLOCK);
+
+        std::shared_ptr<const IndexedRealProperty> x =
+            atoms->getRealProperty("r_m_x_coord");
+        auto reference_x = reference_atoms->getRealProperty("r_m_x_coord");
+        BOOST_REQUIRE(x->encoding() == IndexedEncoding::FLOAT32);
+        BOOST_REQUIRE_EQUAL(x->size(), reference_x->size());
+        for (size_t i = 0; i < x->size(); ++i) {
+            BOOST_REQUIRE_CLOSE(x->get(i), (*reference_x)[i], 1e-4);
+        }
+
+        std::shared_ptr<const IndexedIntProperty> atomic_numbers =
+            atoms->getIntProperty(ATOM_ATOMIC_NUM);
+        BOOST_REQUIRE(atomic_numbers->encoding() == IndexedEncoding::INT8);
+        BOOST_REQUIRE(*atomic_numbers ==
+                      *reference_atoms->getIntProperty(ATOM_ATOMIC_NUM));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(EnsembleSharingReader)
+{
+    // Only the x coordinates and the labels change.
+    std::string mae;
+    for (const char* row :
+         {"0.0 0.0 0.0 C", "0.1 0.0 0.0 C", "0.1 0.0 0.0 N"}) {
+        mae += std::string("f_m_ct {\n"
+                           "  s_m_title\n"
+                           "  :::\n"
+                           "  pose\n"
+                           "  m_atom[2] {\n"
+                           "    i_m_atomic_number\n"
+                           "    r_m_x_coord\n"
+                           "    r_m_y_coord\n"
+                           "    r_m_z_coord\n"
+                           "    s_m_label\n"
+                           "    :::\n"
+                           "    1 6 ") +
+               row +
+               "\n"
+               "    2 8 1.2 0.0 0.0 O\n"
+               "    :::\n"
+               "  }\n"
+               "  m_bond[1] {\n"
+               "    i_m_from\n"
+               "    i_m_to\n"
+               "    i_m_order\n"
+               "    :::\n"
+               "    1 1 2 2\n"
+               "    :::\n"
+               "  }\n"
+               "}\n";
+    }
+
+    // Small buffers spread each block's tokens over several buffers.
+    const size_t buffer_size = 64;
+    for (bool direct : {false, true}) {
+        auto reference_stream = std::make_shared<std::stringstream>(mae);
+        auto stream = std::make_shared<std::stringstream>(mae);
+        std::shared_ptr<MaeParser> reference_parser;
+        std::shared_ptr<MaeParser> parser;
+        if (direct) {
+            reference_parser = std::make_shared<DirectMaeParser>(
+                reference_stream);
+            parser = std::make_shared<DirectMaeParser>(stream, buffer_size);
+        } else {
+            reference_parser = std::make_shared<MaeParser>(reference_stream);
+            parser = std::make_shared<MaeParser>(stream, buffer_size);
+        }
+        Reader reference_reader(reference_parser);
+        Reader r(parser);
+        r.setEnsembleSharing(true, {"s_m_label"});
+
+        std::vector<std::shared_ptr<Block>> cts;
+        std::shared_ptr<Block> b;
+        while ((b = r.next(CT_BLOCK)) != nullptr) {
+            BOOST_REQUIRE(*b == *reference_reader.next(CT_BLOCK));
+            cts.push_back(b);
+        }
+        BOOST_REQUIRE_EQUAL(cts.size(), 3u);
+
+        auto atoms = [&](size_t i) {
+            return cts[i]->getIndexedBlock(ATOM_BLOCK);
+        };
+        auto bonds = [&](size_t i) {
+            return cts[i]->getIndexedBlock(BOND_BLOCK);
+        };
+        for (size_t i = 1; i < cts.size(); ++i) {
+            BOOST_REQUIRE(atoms(i)->getIntProperty(ATOM_ATOMIC_NUM) ==
+                          atoms(0)->getIntProperty(ATOM_ATOMIC_NUM));
+            BOOST_REQUIRE(atoms(i)->getRealProperty(ATOM_Y_COORD) ==
+                          atoms(0)->getRealProperty(ATOM_Y_COORD));
+            BOOST_REQUIRE(bonds(i)->getIntProperty(BOND_ORDER) ==
+                          bonds(0)->getIntProperty(BOND_ORDER));
+        }
+        // Columns are compared with the previous f_m_ct block only.
+        BOOST_REQUIRE(atoms(1)->getRealProperty(ATOM_X_COORD) !=
+                      atoms(0)->getRealProperty(ATOM_X_COORD));
+        BOOST_REQUIRE(atoms(2)->getRealProperty(ATOM_X_COORD) ==
+                      atoms(1)->getRealProperty(ATOM_X_COORD));
+        BOOST_REQUIRE(atoms(1)->getStringProperty("s_m_label") ==
+                      atoms(0)->getStringProperty("s_m_label"));
+        BOOST_REQUIRE(atoms(2)->getStringProperty("s_m_label") !=
+                      atoms(1)->getStringProperty("s_m_label"));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(TestReadNonExistingFile)
 {
     // This file should not exist!
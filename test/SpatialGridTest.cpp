@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+#include "MaeParser.hpp"
+#include "Reader.hpp"
+#include "SpatialGrid.hpp"
+#include "StructureView.hpp"
+
+using namespace schrodinger::mae;
+
+namespace
+{
+const boost::filesystem::path test_samples_path(TEST_SAMPLES_PATH);
+const std::string uncompressed_sample =
+    (test_samples_path / "test.mae").string();
+
+double distance_squared(const Coordinates& c, size_t atom, double x,
+                        double y, double z)
+{
+    const double dx = c(atom, 0) - x;
+    const double dy = c(atom, 1) - y;
+    const double dz = c(atom, 2) - z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+std::vector<uint32_t> brute_force_radius(const Coordinates& c, double x,
+                                         double y, double z, double radius)
+{
+    std::vector<uint32_t> atoms;
+    for (size_t i = 0; i < c.size(); ++i) {
+        if (distance_squared(c, i, x, y, z) <= radius * radius) {
+            atoms.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    return atoms;
+}
+
+std::vector<uint32_t> brute_force_nearest(const Coordinates& c, double x,
+                                          double y, double z, size_t k)
+{
+    std::vector<std::pair<double, uint32_t>> candidates;
+    for (size_t i = 0; i < c.size(); ++i) {
+        candidates.emplace_back(distance_squared(c, i, x, y, z),
+                                static_cast<uint32_t>(i));
+    }
+    std::sort(candidates.begin(), candidates.end());
+    std::vector<uint32_t> atoms;
+    for (size_t i = 0; i < std::min(k, candidates.size()); ++i) {
+        atoms.push_back(candidates[i].second);
+    }
+    return atoms;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(SpatialGridSuite)
+
+BOOST_AUTO_TEST_CASE(QueriesMatchBruteForce)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> position(-20.0, 20.0);
+    auto coordinates = std::make_shared<Coordinates>(500);
+    for (size_t i = 0; i < coordinates->size(); ++i) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            (*coordinates)(i, axis) = position(generator);
+        }
+    }
+
+    for (double cell_size : {1.0, 4.0, 100.0}) {
+        SpatialGrid grid(coordinates, cell_size);
+        BOOST_REQUIRE_EQUAL(grid.size(), 500u);
+        for (int query = 0; query < 20; ++query) {
+            // Include points outside the atoms' bounding box.
+            const double x = 1.5 * position(generator);
+            const double y = 1.5 * position(generator);
+            const double z = 1.5 * position(generator);
+
+            std::vector<uint32_t> within;
+            grid.withinRadius(x, y, z, 6.0, within);
+            std::sort(within.begin(), within.end());
+            BOOST_REQUIRE(within ==
+                          brute_force_radius(*coordinates, x, y, z, 6.0));
+
+            BOOST_REQUIRE(grid.nearest(x, y, z, 7) ==
+                          brute_force_nearest(*coordinates, x, y, z, 7));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(EdgeCases)
+{
+    BOOST_REQUIRE_THROW(SpatialGrid(nullptr, 0.0), std::invalid_argument);
+
+    SpatialGrid empty(nullptr);
+    BOOST_REQUIRE_EQUAL(empty.size(), 0u);
+    BOOST_REQUIRE(empty.nearest(0.0, 0.0, 0.0, 3).empty());
+
+    // Undefined coordinates are left out, and sparse atoms coarsen the grid.
+    auto coordinates = std::make_shared<Coordinates>(3);
+    (*coordinates)(1, 0) = std::numeric_limits<double>::quiet_NaN();
+    (*coordinates)(2, 0) = 1.0e6;
+    SpatialGrid grid(coordinates, 1.0);
+    BOOST_REQUIRE_EQUAL(grid.size(), 2u);
+    BOOST_REQUIRE(grid.cellSize() > 1.0);
+    BOOST_REQUIRE(grid.nearest(1.0e6, 0.0, 0.0, 5) ==
+                  std::vector<uint32_t>({2, 0}));
+
+    std::vector<uint32_t> within;
+    grid.withinRadius(0.0, 0.0, 0.0, 1.0, within);
+    BOOST_REQUIRE(within == std::vector<uint32_t>({0}));
+}
+
+BOOST_AUTO_TEST_CASE(ParsedSpatialGrid)
+{
+    for (bool direct : {false, true}) {
+        auto stream = std::make_shared<std::ifstream>(uncompressed_sample);
+        std::shared_ptr<MaeParser> parser;
+        if (direct) {
+            parser = std::make_shared<DirectMaeParser>(stream);
+        } else {
+            parser = std::make_shared<MaeParser>(stream);
+        }
+        Reader r(parser);
+        r.setSpatialGrid(true, 2.0);
+
+        std::shared_ptr<Block> b;
+        while ((b = r.next(CT_BLOCK)) != nullptr) {
+            const auto grid = b->getSpatialGrid();
+            BOOST_REQUIRE(b->getSpatialGrid() == grid);
+            const auto atoms = b->getIndexedBlock(ATOM_BLOCK);
+            BOOST_REQUIRE_EQUAL(grid->size(), atoms->size());
+
+            // Each atom is its own nearest neighbor.
+            const auto& c = *grid->coordinates();
+            for (size_t i = 0; i < c.size(); ++i) {
+                const auto nearest =
+                    grid->nearest(c(i, 0), c(i, 1), c(i, 2), 1);
+                BOOST_REQUIRE_EQUAL(nearest.size(), 1u);
+                BOOST_REQUIRE_EQUAL(distance_squared(c, nearest[0], c(i, 0),
+                                                     c(i, 1), c(i, 2)),
+                                    0.0);
+            }
+        }
+    }
+
+    // Structure views share their coordinates with the grid.
+    Reader r(uncompressed_sample);
+    r.setStructureViews(true);
+    r.setSpatialGrid(true);
+    const auto b = r.next(CT_BLOCK);
+    BOOST_REQUIRE(b->getSpatialGrid()->coordinates() ==
+                  b->getStructureView()->coordinates());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,99 @@
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "MaeBlock.hpp"
+#include "MaeConstants.hpp"
+#include "MaeParser.hpp"
+#include "Reader.hpp"
+#include "StructureView.hpp"
+
+using namespace schrodinger::mae;
+
+namespace
+{
+const boost::filesystem::path test_samples_path(TEST_SAMPLES_PATH);
+const std::string uncompressed_sample =
+    (test_samples_path / "test.mae").string();
+
+void check_column(const std::vector<int>& values, const IndexedBlock& block,
+                  const std::string& name)
+{
+    const auto property = block.getIntProperty(name);
+    BOOST_REQUIRE_EQUAL(values.size(), property->size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(values[i], property->get(i, 0));
+    }
+}
+
+void check_view(const StructureView& view, const Block& ct)
+{
+    const auto atoms = ct.getIndexedBlock(ATOM_BLOCK);
+    BOOST_REQUIRE_EQUAL(view.atomCount(), atoms->size());
+    check_column(view.atomicNumbers(), *atoms, ATOM_ATOMIC_NUM);
+    check_column(view.formalCharges(), *atoms, ATOM_FORMAL_CHARGE);
+
+    const auto xs = atoms->getRealProperty(ATOM_X_COORD);
+    const auto coordinates = view.coordinates();
+    BOOST_REQUIRE_EQUAL(coordinates->size(), xs->size());
+    for (size_t i = 0; i < xs->size(); ++i) {
+        BOOST_REQUIRE_EQUAL((*coordinates)(i, 0), (*xs)[i]);
+    }
+
+    const auto bonds = ct.getIndexedBlock(BOND_BLOCK);
+    BOOST_REQUIRE_EQUAL(view.bondCount(), bonds->size());
+    check_column(view.bondAtom1(), *bonds, BOND_ATOM_1);
+    check_column(view.bondAtom2(), *bonds, BOND_ATOM_2);
+    check_column(view.bondOrder(), *bonds, BOND_ORDER);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(StructureViewSuite)
+
+BOOST_AUTO_TEST_CASE(ParsedStructureViews)
+{
+    for (bool direct : {false, true}) {
+        auto stream = std::make_shared<std::ifstream>(uncompressed_sample);
+        std::shared_ptr<MaeParser> parser;
+        if (direct) {
+            parser = std::make_shared<DirectMaeParser>(stream);
+        } else {
+            parser = std::make_shared<MaeParser>(stream);
+        }
+        Reader r(parser);
+        r.setStructureViews(true);
+
+        std::shared_ptr<Block> b;
+        size_t count = 0;
+        while ((b = r.next(CT_BLOCK)) != nullptr) {
+            const auto view = b->getStructureView();
+            BOOST_REQUIRE(b->getStructureView() == view);
+            BOOST_REQUIRE(view->atomCount() > 0);
+            check_view(*view, *b);
+            ++count;
+        }
+        BOOST_REQUIRE(count > 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BuiltStructureViews)
+{
+    Reader r(uncompressed_sample);
+    auto b = r.next(CT_BLOCK);
+    const auto view = b->getStructureView();
+    check_view(*view, *b);
+    BOOST_REQUIRE(view->coordinates()->layout() == CoordinateLayout::SOA);
+
+    // Blocks without indexed data have empty views.
+    Block empty(CT_BLOCK);
+    const auto empty_view = empty.getStructureView();
+    BOOST_REQUIRE_EQUAL(empty_view->atomCount(), 0u);
+    BOOST_REQUIRE_EQUAL(empty_view->bondCount(), 0u);
+    BOOST_REQUIRE(empty_view->coordinates() == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()